@@ -14,6 +14,15 @@
  */
 
 #include "8250_uart.h"
+#include <plic.h>
+
+/* transmit ring, used with UART_TX_IRQ */
+static char tx_ring[UART_TX_RING_SIZE];
+static volatile size_t tx_head;
+static volatile size_t tx_tail;
+static volatile bool tx_irq_armed;
+static volatile uart8250_t *tx_irq_uart;
+static volatile uint64_t tx_irq_count;
 
 void uart_init(volatile uart8250_t *uart) {
     
@@ -39,6 +48,9 @@ uart->lcr = UART8250_LCR_8BIT;
     /* clear status */
     (void) uart->lsr;
     uart->msr = 0;
+
+    /* enable and reset fifos */
+    uart->fcr = UART8250_FCR_EN | UART8250_FCR_TX_CLR | UART8250_FCR_RX_CLR;
 }
 
 void uart_enable(volatile uart8250_t *uart){
@@ -55,3 +67,144 @@ void uart_puts(volatile uart8250_t *uart, char const* str){
         uart_putc(uart, *str++);
     }
 }
+
+/**
+ * Write up to a fifo worth of bytes, translating '\n' to "\r\n".
+ * The fifo must be empty. Returns the number of bytes of buf consumed.
+ * A '\n' split across calls is tracked with *cr.
+ */
+static size_t uart_fill_fifo(volatile uart8250_t *uart, const char* buf,
+    size_t len, bool *cr)
+{
+    size_t i = 0;
+
+    for (size_t n = 0; n < UART8250_FIFO_DEPTH && i < len; n++) {
+        if (buf[i] == '\n' && !*cr) {
+            uart->thr = '\r';
+            *cr = true;
+            continue;
+        }
+        uart->thr = buf[i++];
+        *cr = false;
+    }
+
+    return i;
+}
+
+/**
+ * Move bytes from the transmit ring to the fifo if it is empty, and arm the
+ * THRE interrupt while bytes remain. The interrupt is disarmed first, so the
+ * handler does not race with the caller.
+ */
+static void uart_tx_kick(volatile uart8250_t *uart)
+{
+    tx_irq_armed = false;
+    uart->ier = 0;
+
+    if (uart->lsr & UART8250_LSR_THRE) {
+        for (size_t n = 0; n < UART8250_FIFO_DEPTH && tx_head != tx_tail; n++) {
+            uart->thr = tx_ring[tx_head % UART_TX_RING_SIZE];
+            tx_head++;
+        }
+    }
+
+    if (tx_head != tx_tail) {
+        tx_irq_armed = true;
+        uart->ier = UART8250_IER_THRI;
+    }
+}
+
+static void uart_tx_irq_handler(uint32_t irq_id)
+{
+    if (!tx_irq_armed) {
+        tx_irq_uart->ier = 0;
+        return;
+    }
+
+    tx_irq_count++;
+    uart_tx_kick(tx_irq_uart);
+}
+
+/**
+ * Route the THRE interrupt of the uart to M-mode and queue output in the
+ * transmit ring. The ring is drained by the interrupt handler, and by the
+ * writers when full. In M-mode, the interrupt is only taken within explicit
+ * interrupt windows (see plic_irq_window()).
+ */
+void uart_tx_irq_init(volatile uart8250_t *uart, uint32_t irq_id)
+{
+    tx_irq_uart = uart;
+    tx_head = tx_tail = 0;
+    tx_irq_count = 0;
+
+    plic_set_handler(irq_id, uart_tx_irq_handler);
+    plic_set_prio(irq_id, 1);
+    plic_set_enable(PLIC_M_CONTEXT, irq_id, true);
+    plic_set_threshold(PLIC_M_CONTEXT, 0);
+}
+
+/**
+ * Number of bytes in the transmit ring not yet moved to the fifo.
+ */
+size_t uart_tx_pending(void)
+{
+    return tx_tail - tx_head;
+}
+
+/**
+ * Number of THRE interrupts that moved bytes from the ring to the fifo.
+ */
+uint64_t uart_tx_irq_count(void)
+{
+    return tx_irq_count;
+}
+
+static void uart_tx_enqueue(volatile uart8250_t *uart, char c)
+{
+    while ((tx_tail - tx_head) >= UART_TX_RING_SIZE) {
+        while (!(uart->lsr & UART8250_LSR_THRE));
+        uart_tx_kick(uart);
+    }
+
+    tx_ring[tx_tail % UART_TX_RING_SIZE] = c;
+    tx_tail++;
+}
+
+/**
+ * Write a buffer, translating '\n' to "\r\n". Without UART_TX_IRQ, the fifo
+ * is filled each time it empties, instead of polling LSR before every byte.
+ */
+void uart_write(volatile uart8250_t *uart, const char* buf, size_t len){
+    if (UART_TX_IRQ && tx_irq_uart == uart) {
+        for (size_t i = 0; i < len; i++) {
+            if (buf[i] == '\n') {
+                uart_tx_enqueue(uart, '\r');
+            }
+            uart_tx_enqueue(uart, buf[i]);
+        }
+        uart_tx_kick(uart);
+        return;
+    }
+
+    bool cr = false;
+    size_t i = 0;
+    while (i < len) {
+        while(!(uart->lsr & UART8250_LSR_THRE));
+        i += uart_fill_fifo(uart, &buf[i], len - i, &cr);
+    }
+}
+
+/**
+ * Wait until all queued output has been transmitted.
+ */
+void uart_flush(volatile uart8250_t *uart){
+    if (UART_TX_IRQ && tx_irq_uart == uart) {
+        while (tx_head != tx_tail) {
+            while (!(uart->lsr & UART8250_LSR_THRE));
+            uart_tx_kick(uart);
+        }
+    }
+
+    while(!(uart->lsr & UART8250_LSR_TEMT));
+}
+
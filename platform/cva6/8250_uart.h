@@ -23,6 +23,30 @@
 #include <stdlib.h>
 
 #define UART8250_LSR_THRE   (1U << 5)
+#define UART8250_LSR_TEMT   (1U << 6)
+
+#define UART8250_IER_THRI   (1U << 1)
+
+/**
+ * Depth of the transmit FIFO. With the FIFO enabled, LSR.THRE is set when the
+ * FIFO is empty, so up to UART8250_FIFO_DEPTH bytes can be written per check.
+ */
+#ifndef UART8250_FIFO_DEPTH
+#define UART8250_FIFO_DEPTH (16)
+#endif
+
+/**
+ * With UART_TX_IRQ, output is queued in a software ring and moved to the
+ * transmit FIFO by the THRE interrupt handler. Writers only block when the
+ * ring is full.
+ */
+#ifndef UART_TX_IRQ
+#define UART_TX_IRQ         (0)
+#endif
+
+#ifndef UART_TX_RING_SIZE
+#define UART_TX_RING_SIZE   (4096)
+#endif
 
 #define UART8250_REG_WIDTH (4)
 #define UART8250_PAGE_OFFSET (0x40)
@@ -80,5 +104,10 @@ void uart_enable(volatile uart8250_t *uart);
 void uart_init(volatile uart8250_t *uart);
 void uart_puts(volatile uart8250_t *uart, const char* str);
 void uart_putc(volatile uart8250_t *uart, int8_t c);
+void uart_write(volatile uart8250_t *uart, const char* buf, size_t len);
+void uart_flush(volatile uart8250_t *uart);
+void uart_tx_irq_init(volatile uart8250_t *uart, uint32_t irq_id);
+size_t uart_tx_pending(void);
+uint64_t uart_tx_irq_count(void);
 
 #endif /* UART8250_H */
@@ -0,0 +1,20 @@
+#include "clint.h"
+#include <rvh_test.h>
+#include <hart.h>
+
+static inline volatile uint64_t *clint_reg(uint64_t off)
+{
+    return (volatile uint64_t*)(PLAT_CLINT_BASE + off);
+}
+
+/**
+ *  Set the M-mode timer of the calling hart to fire after the given number of CPU cycles
+ *  (converted to mtime ticks, rounded up). The timer interrupt (mie.MTIE) is not enabled here:
+ *  callers enable it around wfi to bound the sleep, without taking the interrupt
+ */
+void clint_set_wakeup(uint64_t cycles)
+{
+    uint64_t ticks = ((cycles * PLAT_RTC_FREQ_HZ) / PLAT_CPU_FREQ_HZ) + 1;
+
+    *clint_reg(CLINT_MTIMECMP_OFF + (hart_id() * 8)) = *clint_reg(CLINT_MTIME_OFF) + ticks;
+}
@@ -0,0 +1,13 @@
+#ifndef _CLINT_H_
+#define _CLINT_H_
+
+#include <stdint.h>
+#include "platform.h"
+
+// Register map (SiFive CLINT)
+#define CLINT_MTIMECMP_OFF      (0x4000ULL)
+#define CLINT_MTIME_OFF         (0xBFF8ULL)
+
+void clint_set_wakeup(uint64_t cycles);
+
+#endif /* _CLINT_H_ */
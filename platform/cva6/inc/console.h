@@ -0,0 +1,19 @@
+#ifndef CONSOLE_H
+#define CONSOLE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Interrupt-driven console output (see 8250_uart.h)
+#ifndef UART_TX_IRQ
+#define UART_TX_IRQ         (0)
+#endif
+
+/**
+ *  Status of the console transmit ring (UART_TX_IRQ=1): bytes not yet sent to the UART,
+ *  and transmit interrupts serviced
+ */
+size_t console_tx_pending(void);
+uint64_t console_tx_irqs(void);
+
+#endif /* CONSOLE_H */
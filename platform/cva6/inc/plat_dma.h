@@ -6,5 +6,6 @@
 #define N_DMA           (1)
 extern uint64_t idma_ids[N_DMA];
 extern uint64_t idma_addr[N_DMA];
+extern uint32_t idma_irq_ids[N_DMA];
 
 #endif /*_IOMMU_H_*/
\ No newline at end of file
@@ -4,7 +4,45 @@
 #define MEM_BASE    (0x80000000)
 #define MEM_SIZE    (0x10000000)
 
+// Number of harts running the framework. Harts with a higher hartid stay parked in _boot
+#ifndef PLAT_N_HARTS
+#define PLAT_N_HARTS    (1)
+#endif
+
+// CPU clock frequency (CSR_CYCLES rate), used to convert cycle counts into wall-clock rates
+#ifndef PLAT_CPU_FREQ_HZ
+#define PLAT_CPU_FREQ_HZ    (50000000ULL)
+#endif
+
+// Stack size of each hart
+#define PLAT_STACK_SIZE (0x100000)
+
 // Base address of the IOMMU Programming Interface
 #define IOMMU_BASE_ADDR            0x50010000ULL
 
+// Number of IOMMU instances. Instance i has its programming interface at PLAT_IOMMU_BASE(i)
+#ifndef PLAT_N_IOMMU
+#define PLAT_N_IOMMU    (1)
+#endif
+#define PLAT_IOMMU_BASE(i)         (IOMMU_BASE_ADDR + (i) * 0x1000ULL)
+
+// MMIO range recorded with MMIO_TRACE (iDMA and IOMMU register interfaces)
+#define MMIO_TRACE_BASE            0x50000000ULL
+#define MMIO_TRACE_SIZE            0x00020000ULL
+
+// Base address of the CLINT, and frequency of its timer (mtime)
+#define PLAT_CLINT_BASE            0x02000000ULL
+#ifndef PLAT_RTC_FREQ_HZ
+#define PLAT_RTC_FREQ_HZ           (1000000ULL)
+#endif
+
+// Base address of the PLIC
+#define PLIC_BASE_ADDR             0x0C000000ULL
+
+// PLIC context of hart 0 in M-mode
+#define PLIC_M_CONTEXT             (0)
+
+// PLIC interrupt source of the console UART
+#define UART_IRQ_ID                (1)
+
 #endif
\ No newline at end of file
@@ -0,0 +1,31 @@
+#ifndef _PLIC_H_
+#define _PLIC_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "platform.h"
+
+// Register map (RISC-V PLIC specification)
+#define PLIC_PRIO_OFF           (0x000000ULL)
+#define PLIC_ENABLE_OFF         (0x002000ULL)
+#define PLIC_ENABLE_STRIDE      (0x80ULL)
+#define PLIC_CTX_OFF            (0x200000ULL)
+#define PLIC_CTX_STRIDE         (0x1000ULL)
+#define PLIC_THRESHOLD_OFF      (0x0ULL)
+#define PLIC_CLAIM_OFF          (0x4ULL)
+
+// Number of interrupt sources with a registered handler
+#define PLIC_N_SOURCES          (64)
+
+typedef void (*plic_handler_t)(uint32_t irq_id);
+
+void plic_set_prio(uint32_t irq_id, uint32_t prio);
+void plic_set_enable(uint32_t ctx, uint32_t irq_id, bool en);
+void plic_set_threshold(uint32_t ctx, uint32_t threshold);
+uint32_t plic_claim(uint32_t ctx);
+void plic_complete(uint32_t ctx, uint32_t irq_id);
+void plic_set_handler(uint32_t irq_id, plic_handler_t handler);
+void plic_irq_rearm(void);
+void plic_irq_window(void);
+
+#endif /* _PLIC_H_ */
@@ -15,4 +15,12 @@ uint64_t idma_ids[N_DMA] = {
  */
 uint64_t idma_addr[N_DMA] = {
     0x50000000ULL
+};
+
+/**
+ *  iDMA interrupt source IDs at the PLIC
+ *  (should be populated with the hardwired value)
+ */
+uint32_t idma_irq_ids[N_DMA] = {
+    8U
 };
\ No newline at end of file
@@ -0,0 +1,118 @@
+#include "plic.h"
+#include <rvh_test.h>
+
+// Handlers of the interrupt sources routed to M-mode
+static plic_handler_t plic_handlers[PLIC_N_SOURCES];
+static size_t plic_n_handlers;
+
+static inline volatile uint32_t *plic_reg(uint64_t off)
+{
+    return (volatile uint32_t*)(PLIC_BASE_ADDR + off);
+}
+
+/**
+ *  Set the priority of an interrupt source (0 disables the source)
+ */
+void plic_set_prio(uint32_t irq_id, uint32_t prio)
+{
+    *plic_reg(PLIC_PRIO_OFF + (irq_id * 4)) = prio;
+}
+
+/**
+ *  Enable/disable an interrupt source for a given context
+ */
+void plic_set_enable(uint32_t ctx, uint32_t irq_id, bool en)
+{
+    volatile uint32_t *reg = plic_reg(PLIC_ENABLE_OFF + (ctx * PLIC_ENABLE_STRIDE) + ((irq_id / 32) * 4));
+
+    if (en)
+        *reg |= (1U << (irq_id % 32));
+    else
+        *reg &= ~(1U << (irq_id % 32));
+}
+
+/**
+ *  Set the priority threshold of a context. Only sources with priority > threshold are notified
+ */
+void plic_set_threshold(uint32_t ctx, uint32_t threshold)
+{
+    *plic_reg(PLIC_CTX_OFF + (ctx * PLIC_CTX_STRIDE) + PLIC_THRESHOLD_OFF) = threshold;
+}
+
+/**
+ *  Claim the highest-priority pending interrupt of a context. Returns 0 if none is pending
+ */
+uint32_t plic_claim(uint32_t ctx)
+{
+    return *plic_reg(PLIC_CTX_OFF + (ctx * PLIC_CTX_STRIDE) + PLIC_CLAIM_OFF);
+}
+
+/**
+ *  Signal completion of a claimed interrupt
+ */
+void plic_complete(uint32_t ctx, uint32_t irq_id)
+{
+    *plic_reg(PLIC_CTX_OFF + (ctx * PLIC_CTX_STRIDE) + PLIC_CLAIM_OFF) = irq_id;
+}
+
+/**
+ *  M-mode external interrupt handler.
+ *  Claims all pending interrupts and dispatches them to the handler of each source
+ */
+static void plic_irq_handler(void)
+{
+    uint32_t irq_id;
+
+    while ((irq_id = plic_claim(PLIC_M_CONTEXT)) != 0)
+    {
+        if (irq_id < PLIC_N_SOURCES && plic_handlers[irq_id] != NULL)
+            plic_handlers[irq_id](irq_id);
+
+        plic_complete(PLIC_M_CONTEXT, irq_id);
+    }
+}
+
+/**
+ *  Register (or unregister, with NULL) the handler of an interrupt source.
+ *  M-mode external interrupts are enabled while at least one handler is registered.
+ *  Sources must be enabled separately with plic_set_prio() and plic_set_enable()
+ */
+void plic_set_handler(uint32_t irq_id, plic_handler_t handler)
+{
+    if (irq_id >= PLIC_N_SOURCES)
+        return;
+
+    plic_n_handlers += (handler != NULL) - (plic_handlers[irq_id] != NULL);
+    plic_handlers[irq_id] = handler;
+
+    if (plic_n_handlers)
+    {
+        set_m_irq_handler(CAUSE_MEI, plic_irq_handler);
+        CSRS(mie, MIE_MEIE);
+    }
+    else
+    {
+        CSRC(mie, MIE_MEIE);
+        set_m_irq_handler(CAUSE_MEI, NULL);
+    }
+}
+
+/**
+ *  Restore the interrupt enable cleared by reset_state() (mie.MEIE) while at least one handler is
+ *  registered. mstatus.MIE is left clear: in M-mode, interrupts are only taken within explicit
+ *  windows (plic_irq_window(), wfi waits), never in the middle of measured code
+ */
+void plic_irq_rearm(void)
+{
+    if (plic_n_handlers)
+        CSRS(mie, MIE_MEIE);
+}
+
+/**
+ *  Take the M-mode external interrupts pending at this point
+ */
+void plic_irq_window(void)
+{
+    CSRS(mstatus, MSTATUS_MIE);
+    CSRC(mstatus, MSTATUS_MIE);
+}
@@ -1,42 +1,156 @@
 
 #include <stdio.h>
+#include <stdint.h>
 #include <sys/stat.h>
 #include <sys/errno.h>
 #include "8250_uart.h"
+#include <log.h>
+#include <console.h>
 uart8250_t * uart = (uart8250_t *) (0x10000000) ;
-// void* memset(void* dest, int byte, size_t len)
-// {
-//   if ((((uintptr_t)dest | len) & (sizeof(uintptr_t)-1)) == 0) {
-//     uintptr_t word = byte & 0xFF;
-//     word |= word << 8;
-//     word |= word << 16;
-//     word |= word << 16 << 16;
-
-//     uintptr_t *d = dest;
-//     while ((uintptr_t)d < (uintptr_t)(dest + len))
-//       *d++ = word;
-//   } else {
-//     char *d = dest;
-//     while (d < (char*)(dest + len))
-//       *d++ = byte;
-//   }
-//   return dest;
-// }
-
-void* memcpy(void* dest, const void* src, size_t len)
+/**
+ *  String/memory functions tuned for rv64imac.
+ *  Destinations are aligned to 8 bytes with byte accesses, and bulk data is moved with unrolled
+ *  64-bit accesses. Misaligned 64-bit accesses trap on CVA6, so misaligned sources are read as
+ *  aligned words and merged with shifts.
+ *  Loop distribution is disabled so GCC does not turn these loops back into memcpy/memset calls
+ */
+#define MEM_WORD        (sizeof(uint64_t))
+#define MEM_WORD_MASK   (MEM_WORD - 1)
+#define MEM_SMALL       (32)
+#define MEM_NO_BUILTIN  __attribute__((optimize("no-tree-loop-distribute-patterns")))
+
+MEM_NO_BUILTIN void* memset(void* dest, int byte, size_t len)
 {
-  if ((((uintptr_t)dest | (uintptr_t)src | len) & (sizeof(uintptr_t)-1)) == 0) {
-    const uintptr_t* s = src;
-    uintptr_t *d = dest;
-    while (d < (uintptr_t*)(dest + len))
-      *d++ = *s++;
-  } else {
-    const char* s = src;
-    char *d = dest;
-    while (d < (char*)(dest + len))
-      *d++ = *s++;
-  }
-  return dest;
+    uint8_t *d = dest;
+
+    if (len >= MEM_SMALL)
+    {
+        uint64_t word = (uint8_t)byte;
+        word |= word << 8;
+        word |= word << 16;
+        word |= word << 32;
+
+        while ((uintptr_t)d & MEM_WORD_MASK)
+        {
+            *d++ = byte;
+            len--;
+        }
+
+        uint64_t *dw = (uint64_t*)d;
+        for (; len >= 8 * MEM_WORD; len -= 8 * MEM_WORD, dw += 8)
+        {
+            dw[0] = word; dw[1] = word; dw[2] = word; dw[3] = word;
+            dw[4] = word; dw[5] = word; dw[6] = word; dw[7] = word;
+        }
+        for (; len >= MEM_WORD; len -= MEM_WORD)
+            *dw++ = word;
+
+        d = (uint8_t*)dw;
+    }
+
+    while (len--)
+        *d++ = byte;
+
+    return dest;
+}
+
+MEM_NO_BUILTIN void* memcpy(void* dest, const void* src, size_t len)
+{
+    uint8_t *d = dest;
+    const uint8_t *s = src;
+
+    if (len >= MEM_SMALL)
+    {
+        while ((uintptr_t)d & MEM_WORD_MASK)
+        {
+            *d++ = *s++;
+            len--;
+        }
+
+        uint64_t *dw = (uint64_t*)d;
+        size_t n_words = len / MEM_WORD;
+
+        if (((uintptr_t)s & MEM_WORD_MASK) == 0)
+        {
+            const uint64_t *sw = (const uint64_t*)s;
+            size_t i = 0;
+
+            for (; i + 8 <= n_words; i += 8)
+            {
+                uint64_t w0 = sw[i + 0], w1 = sw[i + 1], w2 = sw[i + 2], w3 = sw[i + 3];
+                uint64_t w4 = sw[i + 4], w5 = sw[i + 5], w6 = sw[i + 6], w7 = sw[i + 7];
+                dw[i + 0] = w0; dw[i + 1] = w1; dw[i + 2] = w2; dw[i + 3] = w3;
+                dw[i + 4] = w4; dw[i + 5] = w5; dw[i + 6] = w6; dw[i + 7] = w7;
+            }
+            for (; i < n_words; i++)
+                dw[i] = sw[i];
+        }
+        else
+        {
+            // Little-endian merge of consecutive aligned source words. The last word read
+            // shares its aligned 8-byte block with the last source byte needed
+            size_t shift = ((uintptr_t)s & MEM_WORD_MASK) * 8;
+            const uint64_t *sw = (const uint64_t*)((uintptr_t)s & ~MEM_WORD_MASK);
+            uint64_t prev = *sw++;
+
+            for (size_t i = 0; i < n_words; i++)
+            {
+                uint64_t next = *sw++;
+                dw[i] = (prev >> shift) | (next << (64 - shift));
+                prev = next;
+            }
+        }
+
+        d += n_words * MEM_WORD;
+        s += n_words * MEM_WORD;
+        len -= n_words * MEM_WORD;
+    }
+
+    while (len--)
+        *d++ = *s++;
+
+    return dest;
+}
+
+MEM_NO_BUILTIN int memcmp(const void* s1, const void* s2, size_t len)
+{
+    const uint8_t *a = s1;
+    const uint8_t *b = s2;
+
+    // Compare words while both buffers are aligned. The differing byte is found below
+    if ((((uintptr_t)a ^ (uintptr_t)b) & MEM_WORD_MASK) == 0 && len >= MEM_SMALL)
+    {
+        while ((uintptr_t)a & MEM_WORD_MASK)
+        {
+            if (*a != *b)
+                return *a - *b;
+            a++; b++; len--;
+        }
+
+        const uint64_t *aw = (const uint64_t*)a;
+        const uint64_t *bw = (const uint64_t*)b;
+
+        for (; len >= 4 * MEM_WORD; len -= 4 * MEM_WORD, aw += 4, bw += 4)
+        {
+            if ((aw[0] ^ bw[0]) | (aw[1] ^ bw[1]) | (aw[2] ^ bw[2]) | (aw[3] ^ bw[3]))
+                break;
+        }
+        for (; len >= MEM_WORD && *aw == *bw; len -= MEM_WORD)
+        {
+            aw++; bw++;
+        }
+
+        a = (const uint8_t*)aw;
+        b = (const uint8_t*)bw;
+    }
+
+    for (; len; len--, a++, b++)
+    {
+        if (*a != *b)
+            return *a - *b;
+    }
+
+    return 0;
 }
 
 int _read(int file, char *ptr, int len)
@@ -52,19 +166,25 @@ int _read(int file, char *ptr, int len)
 
 int _write(int file, char *ptr, int len)
 {
-    int i;
-    for (i = 0; i < len; ++i)
-    {
-        if (ptr[i] == '\n')
-        {
-            uart_putc(uart, '\r');
-        }
-        uart_putc(uart, ptr[i]);
-    }
+    // Console output is sent to the UART when the log buffer is flushed
+    if (LOG_BUFFER && log_buf_capture(ptr, len))
+        return len;
+
+    uart_write(uart, ptr, len);
 
     return len;
 }
 
+size_t console_tx_pending(void)
+{
+    return uart_tx_pending();
+}
+
+uint64_t console_tx_irqs(void)
+{
+    return uart_tx_irq_count();
+}
+
 int _lseek(int file, int ptr, int dir)
 {
     //errno = ESPIPE;
@@ -101,6 +221,7 @@ void* _sbrk(int increment)
 
 void _exit(int return_value)
 {
+    uart_flush(uart);
     asm ("fence rw, rw" ::: "memory");
     while (1)
     {
@@ -121,4 +242,7 @@ int _kill(int pid, int sig)
 
 void _init(){
     uart_init(uart);
+
+    if (UART_TX_IRQ)
+        uart_tx_irq_init(uart, UART_IRQ_ID);
 }
\ No newline at end of file
@@ -0,0 +1,161 @@
+#include <bench.h>
+#include <stdarg.h>
+
+/**
+ *  Print a benchmark result as "metric value unit", or as a structured record
+ */
+void bench_report(const char *test, const char *unit, uint64_t value, const char *metric, ...)
+{
+    char name[BENCH_METRIC_LEN];
+    va_list args;
+
+    va_start(args, metric);
+    vsnprintf(name, sizeof(name), metric, args);
+    va_end(args);
+
+    if (OUTPUT_FMT != OUTPUT_TEXT)
+    {
+        char str[24];
+        snprintf(str, sizeof(str), "%llu", value);
+        output_record("bench", test, name, str, unit);
+    }
+    else if (LOG_LEVEL >= LOG_INFO)
+        printf("\t%-56s %llu %s\n", name, value, unit);
+}
+
+/**
+ *  Print a benchmark result computed as num/den, with three decimal places.
+ *  Soft-float is avoided by using fixed-point arithmetic
+ */
+void bench_report_ratio(const char *test, const char *unit, uint64_t num, uint64_t den, const char *metric, ...)
+{
+    char name[BENCH_METRIC_LEN];
+    va_list args;
+
+    va_start(args, metric);
+    vsnprintf(name, sizeof(name), metric, args);
+    va_end(args);
+
+    uint64_t milli = (den != 0) ? ((num * 1000) / den) : (0);
+
+    if (OUTPUT_FMT != OUTPUT_TEXT)
+    {
+        char str[24];
+        snprintf(str, sizeof(str), "%llu.%03llu", milli / 1000, milli % 1000);
+        output_record("bench", test, name, str, unit);
+    }
+    else if (LOG_LEVEL >= LOG_INFO)
+        printf("\t%-56s %llu.%03llu %s\n", name, milli / 1000, milli % 1000, unit);
+}
+
+/**
+ *  Returns the histogram bucket of a value
+ */
+static size_t bench_hist_bucket(uint64_t value)
+{
+    if (value < BENCH_HIST_SUB_BUCKETS)
+        return value;
+
+    size_t msb = 63 - __builtin_clzll(value);
+    size_t shift = msb - BENCH_HIST_SUB_BITS;
+    size_t idx = ((shift + 1) << BENCH_HIST_SUB_BITS) + ((value >> shift) & (BENCH_HIST_SUB_BUCKETS - 1));
+
+    return (idx < BENCH_HIST_N_BUCKETS) ? (idx) : (BENCH_HIST_N_BUCKETS - 1);
+}
+
+/**
+ *  Returns the lowest value of a histogram bucket
+ */
+static uint64_t bench_hist_bucket_base(size_t idx)
+{
+    if (idx < BENCH_HIST_SUB_BUCKETS)
+        return idx;
+
+    size_t shift = (idx >> BENCH_HIST_SUB_BITS) - 1;
+
+    return ((BENCH_HIST_SUB_BUCKETS + (idx & (BENCH_HIST_SUB_BUCKETS - 1))) << shift);
+}
+
+void bench_hist_reset(struct bench_hist *hist)
+{
+    hist->count = 0;
+    hist->sum = 0;
+    hist->min = UINT64_MAX;
+    hist->max = 0;
+
+    for (size_t i = 0; i < BENCH_HIST_N_BUCKETS; i++)
+        hist->buckets[i] = 0;
+}
+
+void bench_hist_add(struct bench_hist *hist, uint64_t value)
+{
+    hist->count++;
+    hist->sum += value;
+    hist->min = (value < hist->min) ? (value) : (hist->min);
+    hist->max = (value > hist->max) ? (value) : (hist->max);
+    hist->buckets[bench_hist_bucket(value)]++;
+}
+
+/**
+ *  Returns the quantile num/den of the recorded values (e.g., 999/1000 for p99.9),
+ *  as the base of the bucket holding it, clamped to the recorded min and max
+ */
+uint64_t bench_hist_quantile(struct bench_hist *hist, uint64_t num, uint64_t den)
+{
+    if (hist->count == 0)
+        return 0;
+
+    // Rank of the quantile (1-based, rounded up)
+    uint64_t rank = ((hist->count * num) + den - 1) / den;
+    rank = (rank == 0) ? (1) : (rank);
+
+    uint64_t acc = 0;
+    for (size_t i = 0; i < BENCH_HIST_N_BUCKETS; i++)
+    {
+        acc += hist->buckets[i];
+        if (acc >= rank)
+        {
+            uint64_t value = bench_hist_bucket_base(i);
+            value = (value < hist->min) ? (hist->min) : (value);
+            return (value > hist->max) ? (hist->max) : (value);
+        }
+    }
+
+    return hist->max;
+}
+
+/**
+ *  Print the summary of a histogram: count, min, avg, p50, p90, p99, p99.9 and max.
+ *  Non-empty buckets are printed with LOG_VERBOSE
+ */
+void bench_report_hist(const char *test, const char *unit, struct bench_hist *hist, const char *metric, ...)
+{
+    char name[BENCH_METRIC_LEN];
+    va_list args;
+
+    va_start(args, metric);
+    vsnprintf(name, sizeof(name), metric, args);
+    va_end(args);
+
+    bench_report(test, "samples", hist->count, "%s.count", name);
+
+    if (hist->count == 0)
+        return;
+
+    bench_report(test, unit, hist->min, "%s.min", name);
+    bench_report(test, unit, hist->sum / hist->count, "%s.avg", name);
+    bench_report(test, unit, bench_hist_quantile(hist, 50, 100), "%s.p50", name);
+    bench_report(test, unit, bench_hist_quantile(hist, 90, 100), "%s.p90", name);
+    bench_report(test, unit, bench_hist_quantile(hist, 99, 100), "%s.p99", name);
+    bench_report(test, unit, bench_hist_quantile(hist, 999, 1000), "%s.p99.9", name);
+    bench_report(test, unit, hist->max, "%s.max", name);
+
+    if (OUTPUT_FMT == OUTPUT_TEXT && LOG_LEVEL >= LOG_VERBOSE)
+    {
+        for (size_t i = 0; i < BENCH_HIST_N_BUCKETS; i++)
+        {
+            if (hist->buckets[i])
+                printf("\t\t[%llu, %llu) %u\n", bench_hist_bucket_base(i), bench_hist_bucket_base(i + 1), hist->buckets[i]);
+        }
+    }
+}
\ No newline at end of file
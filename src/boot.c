@@ -0,0 +1,50 @@
+#include <boot.h>
+#include <bench.h>
+
+// Written by _boot after clearing .bss
+uint64_t boot_cycles[2];
+
+static struct {
+    const char *name;
+    uint64_t stamp;
+} phases[BOOT_N_PHASES];
+
+static size_t n_phases = 0;
+
+/**
+ *  Start a boot phase. The previous phase ends here.
+ *  Phases beyond BOOT_N_PHASES are merged into the last one
+ */
+void boot_phase(const char *name)
+{
+    if (n_phases >= BOOT_N_PHASES)
+        return;
+
+    phases[n_phases].name = name;
+    phases[n_phases].stamp = CSRR(CSR_CYCLES);
+    n_phases++;
+}
+
+/**
+ *  Print the cycles spent in each boot phase, ending the last one. The first phases
+ *  are the .bss clear and _init(), measured from the timestamps taken by _boot.
+ *  startup is the value of the cycle counter, i.e., the cycles elapsed since reset
+ */
+void boot_report(void)
+{
+    uint64_t stamp_end = CSRR(CSR_CYCLES);
+
+    INFO("Boot time");
+    bench_report("boot", "cycles", boot_cycles[1] - boot_cycles[0], "bss_clear");
+
+    if (n_phases > 0)
+        bench_report("boot", "cycles", phases[0].stamp - boot_cycles[1], "init");
+
+    for (size_t i = 0; i < n_phases; i++)
+    {
+        uint64_t next = (i + 1 < n_phases) ? (phases[i+1].stamp) : (stamp_end);
+        bench_report("boot", "cycles", next - phases[i].stamp, "%s", phases[i].name);
+    }
+
+    bench_report("boot", "cycles", stamp_end, "startup");
+}
@@ -0,0 +1,74 @@
+#include <hart.h>
+#include <wait.h>
+
+// Set to release the secondary harts parked in _boot (defined in boot.S)
+extern volatile uint64_t hart_release;
+
+extern void mhandler_entry();
+
+// One cache line per mailbox, to avoid false sharing between harts
+static struct {
+    volatile bool online;
+    volatile bool busy;
+    hart_func_t func;
+    void *arg;
+} __attribute__((aligned(64))) mailbox[PLAT_N_HARTS];
+
+/**
+ *  Main loop of the secondary harts, called from _boot once released
+ */
+void hart_main(uint64_t hartid)
+{
+    CSRW(mtvec, mhandler_entry);
+
+    mailbox[hartid].online = true;
+
+    while (true)
+    {
+        while (!mailbox[hartid].busy);
+        __sync_synchronize();
+
+        mailbox[hartid].func(mailbox[hartid].arg);
+
+        __sync_synchronize();
+        mailbox[hartid].busy = false;
+    }
+}
+
+/**
+ *  Release the secondary harts. Must be called after clearing .bss
+ */
+void harts_release(void)
+{
+    __sync_synchronize();
+    hart_release = 1;
+
+    for (unsigned h = 1; h < PLAT_N_HARTS; h++)
+        WAIT_UNTIL(mailbox[h].online, WAIT_BUDGET, "secondary hart online");
+
+    VERBOSE("%u harts online", PLAT_N_HARTS);
+}
+
+/**
+ *  Run func(arg) on a secondary hart. The hart must be idle
+ */
+void hart_start(unsigned hart, hart_func_t func, void *arg)
+{
+    if (hart == 0 || hart >= PLAT_N_HARTS || mailbox[hart].busy)
+        ERROR("invalid or busy hart");
+
+    mailbox[hart].func = func;
+    mailbox[hart].arg = arg;
+
+    __sync_synchronize();
+    mailbox[hart].busy = true;
+}
+
+/**
+ *  Wait until a secondary hart completes its work item
+ */
+void hart_join(unsigned hart)
+{
+    WAIT_UNTIL(!mailbox[hart].busy, WAIT_BUDGET, "secondary hart work completion");
+    __sync_synchronize();
+}
@@ -1,5 +1,16 @@
 #include <idma.h>
 #include <rvh_test.h>
+#include <plat_dma.h>
+#include <plic.h>
+#include <clint.h>
+#include <wait.h>
+
+// Completion timestamps (CSR_CYCLES) recorded by the iDMA interrupt handler, indexed by transfer ID
+volatile uint64_t idma_irq_stamps[N_DMA][IDMA_IRQ_N_STAMPS];
+// Last transfer ID seen as completed by the interrupt handler
+volatile uint64_t idma_irq_last_id[N_DMA];
+// Number of iDMA interrupts serviced
+volatile uint64_t idma_irq_count;
 
 /**
  *  Setup iDMA for transfer
@@ -21,19 +32,225 @@ void idma_setup_addr(struct idma *dma_ut, uint64_t src, uint64_t dst)
     write64((uintptr_t)&dma_ut->dest_addr, dst);         // Destination address
 }
 
+/**
+ *  Launch a transfer with the current configuration without waiting for completion.
+ *  Returns the transfer ID, or 0 if the transfer was rejected by the iDMA
+ */
+uint64_t idma_submit(struct idma *dma_ut)
+{
+    return read64((uintptr_t)&dma_ut->next_transfer_id);
+}
+
+/**
+ *  Returns the ID of the last completed transfer
+ */
+uint64_t idma_poll(struct idma *dma_ut)
+{
+    return read64((uintptr_t)&dma_ut->last_transfer_id_complete);
+}
+
+/**
+ *  Check whether the transfer with ID trans_id has completed.
+ *  Transfer IDs are monotonic, so any ID not newer than the last completed one is complete
+ */
+bool idma_is_complete(struct idma *dma_ut, uint64_t trans_id)
+{
+    return ((int64_t)(idma_poll(dma_ut) - trans_id) >= 0);
+}
+
+/**
+ *  Wait for completion of the transfer with ID trans_id
+ */
+void idma_wait(struct idma *dma_ut, uint64_t trans_id)
+{
+    WAIT_UNTIL(idma_is_complete(dma_ut, trans_id), WAIT_BUDGET, "iDMA transfer completion");
+}
+
 /**
  *  Init iDMA transfer and wait for completion 
  */
 int idma_exec_transfer(struct idma *dma_ut)
 {
-    uint64_t trans_id = read64((uintptr_t)&dma_ut->next_transfer_id);
+    uint64_t trans_id = idma_submit(dma_ut);
 
     if (!trans_id)
         return -1;
 
     // Poll transfer status
-    while (read64((uintptr_t)&dma_ut->last_transfer_id_complete) != trans_id)
-        ;
+    idma_wait(dma_ut, trans_id);
 
     return 0;
+}
+
+/**
+ *  Stream a scatter-gather list into the iDMA, launching each segment as soon as the previous
+ *  one has been accepted. Source and destination addresses (and the length, if it changes) are
+ *  reprogrammed while previous segments are still draining. Segments rejected by the iDMA are retried.
+ *  Returns the transfer ID of the last segment (0 if the list is empty)
+ */
+uint64_t idma_sg_submit(struct idma *dma_ut, const struct idma_sg_seg *segs, size_t n_segs)
+{
+    uint64_t trans_id = 0;
+    uint64_t len = 0;
+
+    if (n_segs == 0)
+        return 0;
+
+    write64((uintptr_t)&dma_ut->config, ~(IDMA_SERIALIZE|IDMA_DEBURST|IDMA_DECOUPLE));
+
+    for (size_t i = 0; i < n_segs; i++)
+    {
+        write64((uintptr_t)&dma_ut->src_addr, segs[i].src);
+        write64((uintptr_t)&dma_ut->dest_addr, segs[i].dst);
+
+        if (segs[i].len != len || i == 0)
+        {
+            len = segs[i].len;
+            write64((uintptr_t)&dma_ut->num_bytes, len);
+        }
+
+        WAIT_UNTIL((trans_id = idma_submit(dma_ut)) != 0, WAIT_BUDGET, "iDMA S/G segment accepted");
+    }
+
+    return trans_id;
+}
+
+/**
+ *  Transfer a scatter-gather list and wait for completion of all segments
+ */
+void idma_sg_exec(struct idma *dma_ut, const struct idma_sg_seg *segs, size_t n_segs)
+{
+    uint64_t trans_id = idma_sg_submit(dma_ut, segs, n_segs);
+
+    // Segments complete in order: the last one completes after all others
+    if (trans_id)
+        idma_wait(dma_ut, trans_id);
+}
+
+/**
+ *  Returns the index of an iDMA engine in the platform arrays
+ */
+static size_t idma_index(struct idma *dma_ut)
+{
+    for (size_t e = 0; e < N_DMA; e++)
+    {
+        if (idma_addr[e] == (uintptr_t)dma_ut)
+            return e;
+    }
+
+    ERROR("unknown iDMA engine");
+}
+
+/**
+ *  iDMA completion interrupt handler (M-mode external interrupt, dispatched by the PLIC driver).
+ *  Records the completion timestamp of all transfers completed since the last interrupt
+ */
+static void idma_irq_handler(uint32_t irq_id)
+{
+    uint64_t stamp = CSRR(CSR_CYCLES);
+
+    for (size_t e = 0; e < N_DMA; e++)
+    {
+        if (idma_irq_ids[e] != irq_id)
+            continue;
+
+        struct idma *dma_ut = (void*)idma_addr[e];
+
+        // Clear pending bits before reading the completion counter, so later completions raise a new interrupt
+        write64((uintptr_t)&dma_ut->ipsr, 0x3ULL);
+        uint64_t last = idma_poll(dma_ut);
+
+        // Interrupts may be coalesced: stamp all transfers completed since the previous one
+        uint64_t id = idma_irq_last_id[e] + 1;
+        if ((int64_t)(last - id) >= IDMA_IRQ_N_STAMPS)
+            id = last - IDMA_IRQ_N_STAMPS + 1;
+
+        for (; (int64_t)(last - id) >= 0; id++)
+            idma_irq_stamps[e][id % IDMA_IRQ_N_STAMPS] = stamp;
+
+        idma_irq_last_id[e] = last;
+    }
+
+    idma_irq_count++;
+}
+
+/**
+ *  Route iDMA completion interrupts to M-mode through the PLIC and register the handler.
+ *  In M-mode, interrupts are only taken within idma_wait_irq()
+ */
+void idma_irq_init(void)
+{
+    for (size_t e = 0; e < N_DMA; e++)
+    {
+        struct idma *dma_ut = (void*)idma_addr[e];
+
+        write64((uintptr_t)&dma_ut->ipsr, 0x3ULL);
+        idma_irq_last_id[e] = idma_poll(dma_ut);
+
+        plic_set_handler(idma_irq_ids[e], idma_irq_handler);
+        plic_set_prio(idma_irq_ids[e], 1);
+        plic_set_enable(PLIC_M_CONTEXT, idma_irq_ids[e], true);
+    }
+
+    plic_set_threshold(PLIC_M_CONTEXT, 0);
+    idma_irq_count = 0;
+}
+
+/**
+ *  Disable iDMA completion interrupts and unregister the handler
+ */
+void idma_irq_deinit(void)
+{
+    for (size_t e = 0; e < N_DMA; e++)
+    {
+        plic_set_enable(PLIC_M_CONTEXT, idma_irq_ids[e], false);
+        plic_set_handler(idma_irq_ids[e], NULL);
+    }
+}
+
+/**
+ *  Returns true once the interrupt handler has recorded the completion of trans_id. Otherwise, sleeps
+ *  in wfi and opens a window (mstatus.MIE) to take the interrupt. wfi wakes up on a pending enabled
+ *  interrupt even with mstatus.MIE clear, so a completion cannot be lost between the check and the wfi.
+ *  The timer interrupt is only enabled during wfi, so it wakes the hart up but is never taken
+ */
+static bool idma_irq_wait_step(size_t e, uint64_t trans_id)
+{
+    if ((int64_t)(idma_irq_last_id[e] - trans_id) >= 0)
+        return true;
+
+    CSRS(mie, MIE_MTIE);
+    wfi();
+    CSRC(mie, MIE_MTIE);
+
+    CSRS(mstatus, MSTATUS_MIE);
+    CSRC(mstatus, MSTATUS_MIE);
+
+    return false;
+}
+
+/**
+ *  Wait for completion of the transfer with ID trans_id sleeping in wfi, instead of polling the iDMA.
+ *  The CLINT timer wakes the hart up once the wait budget is spent, so a lost interrupt is reported
+ *  as a timeout. mstatus.MIE is cleared during the wait and restored afterwards
+ */
+void idma_wait_irq(struct idma *dma_ut, uint64_t trans_id)
+{
+    size_t e = idma_index(dma_ut);
+    uint64_t mie = CSRR(mstatus) & MSTATUS_MIE;
+
+    CSRC(mstatus, MSTATUS_MIE);
+    clint_set_wakeup(WAIT_BUDGET);
+
+    WAIT_UNTIL(idma_irq_wait_step(e, trans_id), WAIT_BUDGET, "iDMA completion IRQ");
+
+    CSRS(mstatus, mie);
+}
+
+/**
+ *  Returns the completion timestamp recorded by the interrupt handler for a transfer ID
+ */
+uint64_t idma_irq_stamp(struct idma *dma_ut, uint64_t trans_id)
+{
+    return idma_irq_stamps[idma_index(dma_ut)][trans_id % IDMA_IRQ_N_STAMPS];
 }
\ No newline at end of file
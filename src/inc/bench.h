@@ -0,0 +1,50 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <rvh_test.h>
+
+// Maximum length of a benchmark metric name
+#define BENCH_METRIC_LEN    (64)
+
+// Print the name of the benchmark and create test_status variable.
+// Benchmark results are printed in the following lines
+#define BENCH_START()\
+    TEST_START();\
+    if(OUTPUT_FMT == OUTPUT_TEXT && LOG_LEVEL >= LOG_INFO && LOG_LEVEL < LOG_DETAIL) printf("\n");
+
+// Report a result of the current benchmark. The metric name accepts printf-like arguments
+#define BENCH_REPORT(unit, value, metric...)\
+    bench_report(__test_name, unit, value, metric)
+
+// Report num/den as a result of the current benchmark, with three decimal places
+#define BENCH_REPORT_RATIO(unit, num, den, metric...)\
+    bench_report_ratio(__test_name, unit, num, den, metric)
+
+// Log-bucketed histogram: values below BENCH_HIST_SUB_BUCKETS are exact, and each power of two above
+// is split in BENCH_HIST_SUB_BUCKETS linear sub-buckets (relative error below 1/BENCH_HIST_SUB_BUCKETS)
+#define BENCH_HIST_SUB_BITS     (3)
+#define BENCH_HIST_SUB_BUCKETS  (1ULL << BENCH_HIST_SUB_BITS)
+#define BENCH_HIST_N_OCTAVES    (40)    // Values up to 2^40 cycles
+#define BENCH_HIST_N_BUCKETS    ((BENCH_HIST_N_OCTAVES - BENCH_HIST_SUB_BITS + 1) * BENCH_HIST_SUB_BUCKETS)
+
+struct bench_hist {
+    uint64_t count;
+    uint64_t sum;
+    uint64_t min;
+    uint64_t max;
+    uint32_t buckets[BENCH_HIST_N_BUCKETS];
+};
+
+// Report count, min, avg, p50, p90, p99, p99.9 and max of a histogram of the current benchmark
+#define BENCH_REPORT_HIST(unit, hist, metric...)\
+    bench_report_hist(__test_name, unit, hist, metric)
+
+void bench_hist_reset(struct bench_hist *hist);
+void bench_hist_add(struct bench_hist *hist, uint64_t value);
+uint64_t bench_hist_quantile(struct bench_hist *hist, uint64_t num, uint64_t den);
+
+void bench_report(const char *test, const char *unit, uint64_t value, const char *metric, ...);
+void bench_report_ratio(const char *test, const char *unit, uint64_t num, uint64_t den, const char *metric, ...);
+void bench_report_hist(const char *test, const char *unit, struct bench_hist *hist, const char *metric, ...);
+
+#endif /* BENCH_H */
@@ -0,0 +1,17 @@
+#ifndef BOOT_H
+#define BOOT_H
+
+#include <rvh_test.h>
+
+// Maximum number of boot phases
+#define BOOT_N_PHASES   (16)
+
+/**
+ *  Cycle counter sampled by _boot at entry ([0]) and after clearing .bss ([1])
+ */
+extern uint64_t boot_cycles[2];
+
+void boot_phase(const char *name);
+void boot_report(void);
+
+#endif /* BOOT_H */
@@ -55,6 +55,8 @@
 #endif
 
 
+#define MSTATUS_MIE_OFF     (3)
+#define MSTATUS_MIE     (1ULL << MSTATUS_MIE_OFF)
 #define MSTATUS_MPRV_OFF    (17)
 #define MSTATUS_MPRV    (1ULL << MSTATUS_MPRV_OFF)
 #define MSTATUS_TW_OFF  (21)
@@ -102,6 +104,11 @@
 #define SIE_UEIE (1ULL << 8)
 #define SIE_SEIE (1ULL << 9)
 
+#define MIE_MTIE (1ULL << 7)
+#define MIE_MEIE (1ULL << 11)
+#define MIP_MTIP MIE_MTIE
+#define MIP_MEIP MIE_MEIE
+
 #define SIP_USIP SIE_USIE
 #define SIP_SSIP SIE_SSIE
 #define SIP_UTIP SIE_UTIE
@@ -130,6 +137,7 @@
 #define CAUSE_UEI (8 | CAUSE_INT_BIT)
 #define CAUSE_SEI (9 | CAUSE_INT_BIT)
 #define CAUSE_VSEI (10 | CAUSE_INT_BIT)
+#define CAUSE_MEI (11 | CAUSE_INT_BIT)
 #define CAUSE_IAM (0)
 #define CAUSE_IAF (1)
 #define CAUSE_ILI (2)
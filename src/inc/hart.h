@@ -0,0 +1,30 @@
+#ifndef HART_H
+#define HART_H
+
+#include <rvh_test.h>
+
+/**
+ *  Secondary harts (hartid 1 to PLAT_N_HARTS-1) run work items posted by the primary hart (hartid 0).
+ *  Each secondary hart has a mailbox holding one work item, and waits for it with interrupts disabled.
+ *  Drivers are not reentrant: concurrent work items must not use the same hardware resource
+ *  (e.g., the CQ or an iDMA engine), and should not print, since console output is not serialized
+ */
+typedef void (*hart_func_t)(void *arg);
+
+/**
+ *  Hartid of the calling hart. _boot keeps it in tp, which is not used by the compiler
+ *  and preserved by the trap handlers, so it can be read at any privilege level
+ */
+static inline unsigned hart_id(void)
+{
+    uint64_t id;
+    asm("mv %0, tp" : "=r"(id));
+    return (unsigned)id;
+}
+
+void hart_main(uint64_t hartid);
+void harts_release(void);
+void hart_start(unsigned hart, hart_func_t func, void *arg);
+void hart_join(unsigned hart);
+
+#endif /* HART_H */
@@ -7,6 +7,9 @@
 #define IDMA_DEBURST    (1ULL << 1)
 #define IDMA_SERIALIZE  (1ULL << 2)
 
+// Number of completion timestamps kept by the interrupt handler (per engine)
+#define IDMA_IRQ_N_STAMPS   (64)
+
 struct idma {
   uint64_t src_addr;
   uint64_t dest_addr;
@@ -18,8 +21,28 @@ struct idma {
   uint64_t ipsr;
 }__attribute__((__packed__, aligned(PAGE_SIZE)));
 
+// Scatter-gather segment
+struct idma_sg_seg {
+  uint64_t src;
+  uint64_t dst;
+  uint64_t len;
+};
+
 void idma_setup(struct idma *dma_ut, uint64_t src, uint64_t dst, uint64_t n_bytes);
 void idma_setup_addr(struct idma *dma_ut, uint64_t src, uint64_t dst);
+uint64_t idma_submit(struct idma *dma_ut);
+uint64_t idma_poll(struct idma *dma_ut);
+bool idma_is_complete(struct idma *dma_ut, uint64_t trans_id);
+void idma_wait(struct idma *dma_ut, uint64_t trans_id);
 int idma_exec_transfer(struct idma *dma_ut);
+uint64_t idma_sg_submit(struct idma *dma_ut, const struct idma_sg_seg *segs, size_t n_segs);
+void idma_sg_exec(struct idma *dma_ut, const struct idma_sg_seg *segs, size_t n_segs);
+
+void idma_irq_init(void);
+void idma_irq_deinit(void);
+void idma_wait_irq(struct idma *dma_ut, uint64_t trans_id);
+uint64_t idma_irq_stamp(struct idma *dma_ut, uint64_t trans_id);
+
+extern volatile uint64_t idma_irq_count;
 
 #endif  /* _IDMA_H_ */
\ No newline at end of file
@@ -0,0 +1,39 @@
+#ifndef LOG_H
+#define LOG_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ *  LOG_BUFFER should be passed through MAKE.
+ *  With LOG_BUFFER=1, log messages and console output are stored in a RAM ring buffer
+ *  and only sent to the UART when the buffer is flushed (end of test, END() or ERROR())
+ */
+#ifndef LOG_BUFFER
+#define LOG_BUFFER      (0)
+#endif
+
+// Size of the log ring buffer, in 64-bit words
+#ifndef LOG_BUF_WORDS
+#define LOG_BUF_WORDS   (16384)
+#endif
+
+// Maximum number of arguments of a buffered log message
+#define LOG_MAX_ARGS    (8)
+
+// Number of arguments following the format string (up to LOG_MAX_ARGS)
+#define LOG_NARGS(...)  LOG_NARGS_(__VA_ARGS__, 8, 7, 6, 5, 4, 3, 2, 1, 0)
+#define LOG_NARGS_(fmt, _1, _2, _3, _4, _5, _6, _7, _8, n, ...) n
+
+#if LOG_BUFFER
+# define LOG_FLUSH()    log_flush()
+#else
+# define LOG_FLUSH()
+#endif
+
+void log_buf_push(size_t nargs, const char *fmt, ...);
+bool log_buf_capture(const char *ptr, size_t len);
+void log_flush(void);
+
+#endif /* LOG_H */
@@ -0,0 +1,59 @@
+#ifndef MMIO_STATS_H
+#define MMIO_STATS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <platform.h>
+
+/**
+ *  MMIO_STATS should be passed through MAKE.
+ *  With MMIO_STATS=1, each read32/read64/write32/write64 call site targeting the MMIO range
+ *  [MMIO_TRACE_BASE, MMIO_TRACE_BASE + MMIO_TRACE_SIZE) counts its reads and writes.
+ *  Counts are aggregated per function and printed at the end of each test, after boot
+ *  and for the whole run
+ */
+#ifndef MMIO_STATS
+#define MMIO_STATS      (0)
+#endif
+
+// Number of functions listed per table. With structured output, all functions are reported
+#ifndef MMIO_STATS_TOP
+#define MMIO_STATS_TOP  (10)
+#endif
+
+// Maximum number of distinct functions with MMIO access sites
+#define MMIO_STATS_FUNCS    (128)
+
+/**
+ *  MMIO access site: identifies a read32/read64/write32/write64 call and counts its accesses.
+ *  Sites are placed in the .mmio_sites section, so all of them can be reported
+ */
+struct mmio_site {
+    const char *func;
+    uint32_t line;
+    uint64_t n[2];          // Reads, writes
+    uint64_t mark[2];       // Counts at the start of the current test
+};
+
+#if MMIO_STATS
+# define MMIO_STATS_ACCESS(addr, write) {\
+    static struct mmio_site __mmio_site __attribute__((section(".mmio_sites"), used)) =\
+        {.func = __func__, .line = __LINE__};\
+    if (((addr) - MMIO_TRACE_BASE) < MMIO_TRACE_SIZE)\
+        __atomic_fetch_add(&__mmio_site.n[(write)], 1, __ATOMIC_RELAXED);\
+}
+# define MMIO_STATS_BEGIN()             mmio_stats_begin()
+# define MMIO_STATS_REPORT(name)        mmio_stats_report(name, false)
+# define MMIO_STATS_REPORT_TOTAL()      mmio_stats_report("total", true)
+#else
+# define MMIO_STATS_BEGIN()
+# define MMIO_STATS_REPORT(name)
+# define MMIO_STATS_REPORT_TOTAL()
+#endif
+
+void mmio_stats_begin(void);
+void mmio_stats_report(const char *name, bool total);
+uint64_t mmio_stats_count(void);
+
+#endif /* MMIO_STATS_H */
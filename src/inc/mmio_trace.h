@@ -0,0 +1,37 @@
+#ifndef MMIO_TRACE_H
+#define MMIO_TRACE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <platform.h>
+
+/**
+ *  MMIO_TRACE should be passed through MAKE.
+ *  With MMIO_TRACE=1, every access to the MMIO range [MMIO_TRACE_BASE, MMIO_TRACE_BASE + MMIO_TRACE_SIZE)
+ *  issued through read32/read64/write32/write64 is recorded in a RAM ring buffer as (cycle, address,
+ *  value, direction). The trace is printed at the end of each test and upon errors,
+ *  and can be summarized or replayed offline with tools/mmio_trace.py
+ */
+#ifndef MMIO_TRACE
+#define MMIO_TRACE      (0)
+#endif
+
+// Number of entries of the trace ring buffer. When full, the oldest entries are overwritten
+#ifndef MMIO_TRACE_ENTRIES
+#define MMIO_TRACE_ENTRIES  (4096)
+#endif
+
+#if MMIO_TRACE
+# define MMIO_TRACE_ACCESS(addr, val, size, wr)\
+    if (((addr) - MMIO_TRACE_BASE) < MMIO_TRACE_SIZE) { mmio_trace_record((addr), (val), (size), (wr)); }
+# define MMIO_TRACE_DUMP(name)  mmio_trace_dump(name)
+#else
+# define MMIO_TRACE_ACCESS(addr, val, size, wr)
+# define MMIO_TRACE_DUMP(name)
+#endif
+
+void mmio_trace_record(uintptr_t addr, uint64_t val, uint8_t size, bool write);
+void mmio_trace_dump(const char *name);
+
+#endif /* MMIO_TRACE_H */
@@ -3,6 +3,14 @@
 
 #include <rv_iommu_tests.h>
 
+/**
+ *  STATIC_TABLES=1: the page tables, MSI page table, MRIF and DDT are generated at build time
+ *  by tools/gen_tables.c and loaded as initialized data, instead of being filled at boot
+ */
+#ifndef STATIC_TABLES
+#define STATIC_TABLES   (0)
+#endif
+
 /***************************************************************************************************
  *                             RISC-V Page Tables Related Macros                                   *
  **************************************************************************************************/
@@ -75,6 +83,11 @@
 // Number of entries of the MSI Page Table (PoT, associated with N of set bits in the MSI mask)
 #define MSI_N_ENTRIES       (32)
 
+// Number of 4-kiB tables of the test page tables and 64-bit words of the MRIF
+#define S1PT_N_TABLES       (6)
+#define S2PT_N_TABLES       (5)
+#define MRIF_N_DWORDS       (64)
+
 // SPA of the base Interrupt File, i.e., physical address of the page (IF) pointed to by the first entry of the MSI PT.
 // 0x8000_0000 + 0x0400_0000 = 0x84000000
 #define MSI_BASE_IF_SPA (MEM_BASE+(MEM_SIZE/4))
@@ -109,6 +122,26 @@
 // Base Supervisor Physical Address of 4-kiB pages
 #define TEST_PPAGE_BASE (MEM_BASE+(MEM_SIZE/2))     // 0x8000_0000 + 0x0800_0000 = 0x88000000
 
+// Benchmark window: 4-kiB pages mapped with GVA == GPA, backed by a contiguous SPA range.
+// VPN[2]/GPPN[2] select the seventh entry of the first-stage and second-stage root tables.
+// Each stage uses one second-level table and BENCH_N_PT leaf tables.
+#define BENCH_VADDR_BASE    (0x180000000ULL)                    // vpn[2] = 6
+#define BENCH_PADDR_BASE    (MEM_BASE+((MEM_SIZE/4)*3))         // 0x8000_0000 + 0x0C00_0000 = 0x8C000000
+#define BENCH_N_PT          (8)
+#define BENCH_N_PAGES       (BENCH_N_PT * 512)                  // 4096 pages (16 MiB)
+#define BENCH_WINDOW_SIZE   (BENCH_N_PAGES * PAGE_SIZE)
+
+// The same SPA range is also reachable through:
+//  - 2-MiB pages with GVA == GPA (seventh entry of both root tables)
+//  - First-stage-only aliases (GVA -> SPA) with 4-kiB and 2-MiB pages, for iohgatp in Bare mode.
+//    These reuse the second-stage leaf tables of the window, since Sv39 and Sv39x4 leaf PTEs share the same format.
+//  - 1-GiB pages, through the identity mapping of TEST_VADDR_1GIB in both stages
+#define BENCH_VADDR_2MIB_BASE       (0x1C0000000ULL)    // vpn[2] = 7
+#define BENCH_S1_VADDR_BASE         (0x200000000ULL)    // vpn[2] = 8
+#define BENCH_S1_VADDR_2MIB_BASE    (0x240000000ULL)    // vpn[2] = 9
+#define BENCH_VADDR_1GIB_BASE       (BENCH_PADDR_BASE)
+#define BENCH_N_SUPERPAGES          (BENCH_WINDOW_SIZE / SUPERPAGE_SIZE(1))
+
 /***************************************************************************************************
  **************************************************************************************************/
 
@@ -156,6 +189,14 @@ enum test_page {
 extern pte_t s1pt[][512];
 extern pte_t s2pt_root[];
 extern pte_t s2pt[][512];
+extern pte_t s1pt_tenant_root[][512];
+extern pte_t s2pt_tenant_root[][2048];
+extern pte_t s1pt_bench[][512];
+extern pte_t s2pt_bench[][512];
+extern pte_t s1pt_bench_2mib[];
+extern pte_t s2pt_bench_2mib[];
+extern uint64_t msi_pt[];
+extern uint64_t mrif[];
 
 // Returns the base address of the virtual page specified by 'tp'
 static inline uintptr_t virt_page_base(enum test_page tp){
@@ -183,10 +224,29 @@ static inline uintptr_t phys_page_base(enum test_page tp){
     }
 }
 
+// Returns the IOVA of the byte at offset 'off' of the benchmark window
+static inline uintptr_t bench_vaddr(uint64_t off){
+    if(off < BENCH_WINDOW_SIZE){
+        return (uintptr_t)(BENCH_VADDR_BASE+off);
+    } else {
+        ERROR("trying to get invalid benchmark virtual address");
+    }
+}
+
+// Returns the SPA of the byte at offset 'off' of the benchmark window
+static inline uintptr_t bench_paddr(uint64_t off){
+    if(off < BENCH_WINDOW_SIZE){
+        return (uintptr_t)(BENCH_PADDR_BASE+off);
+    } else {
+        ERROR("trying to get invalid benchmark physical address");
+    }
+}
+
 void s1pt_init(void);
 void s2pt_init(void);
 void s1pt_switch(void);
 void s2pt_switch(void);
+void tenant_pt_init(void);
 void msi_pt_init(void);
 void mrif_init(void);
 
@@ -8,6 +8,7 @@
 #include <rv_iommu_tests.h>
 
 #define IOMMU_MAX_HPM_COUNTERS 31
+#define IOMMU_MAX_MSI_CFG_TABLE 16
 
 // Number of entries in the CQ. Must be POT
 #define CQ_N_ENTRIES    (64 )
@@ -117,7 +118,62 @@
 #define MSI_DATA_HPM   (0xDEADBEEFUL)
 #define MSI_VCTL_HPM   (0x0UL)
 
+/**
+ *  Common IOMMU configurations applied with rv_iommu_fixture()
+ */
+enum iommu_fixture {
+    FX_NONE,            // Configuration modified outside rv_iommu_fixture()
+    FX_OFF,             // IOMMU OFF
+    FX_BARE,            // IOMMU Bare
+    FX_STAGES_BARE,     // 1LVL | iosatp: Bare | iohgatp: Bare
+    FX_S1_ONLY,         // 1LVL | iosatp: Sv39 | iohgatp: Bare
+    FX_S2_ONLY,         // 1LVL | iosatp: Bare | iohgatp: Sv39x4
+    FX_S2_ONLY_MSI,     // 1LVL | iosatp: Bare | iohgatp: Sv39x4 | msiptp: Flat
+    FX_TWO_STAGE,       // 1LVL | iosatp: Sv39 | iohgatp: Sv39x4
+    FX_TWO_STAGE_MSI,   // 1LVL | iosatp: Sv39 | iohgatp: Sv39x4 | msiptp: Flat
+};
+
+/**
+ *  Software-owned registers of an instance, shadowed by the driver (see rv_iommu_shadow_sync())
+ */
+struct iommu_shadow {
+    uint32_t fctl;
+    uint64_t icvec;
+    uint32_t iocntinh;
+    uint64_t iohpmevt[IOMMU_MAX_HPM_COUNTERS];
+    uint64_t tr_req_ctl;
+    struct {
+        uint64_t addr;
+        uint32_t data;
+        uint32_t vctl;
+    } msi_cfg_tbl[IOMMU_MAX_MSI_CFG_TABLE];
+};
+
+/**
+ *  IOMMU instance handle, set up by init_iommu().
+ *  Instances share the page tables, MSI page table, MRIF and DDT, so DC and PTE updates
+ *  apply to all of them (each one caches them in its own DDTC/IOTLB)
+ */
+struct rv_iommu {
+    uintptr_t base;         // Register interface
+    uint64_t caps;          // capabilities register
+    uint64_t *cq;           // CQ buffer
+    uint64_t *fq;           // FQ buffer
+    struct ddt *ddt;        // Root DDT
+    uint32_t cqt;           // CQ tail (software-owned)
+    uint32_t fqh;           // FQ head (software-owned)
+    enum iommu_fixture fixture; // Configuration applied by the last rv_iommu_fixture()
+    struct iommu_shadow shadow;
+};
+
+extern struct rv_iommu rv_iommu_inst[PLAT_N_IOMMU];
+
 void init_iommu(void);
+void rv_iommu_select(struct rv_iommu *inst);
+struct rv_iommu *rv_iommu_selected(void);
+bool rv_iommu_fixture(enum iommu_fixture fx);
+void rv_iommu_snapshot(void);
+size_t rv_iommu_restore(void);
 
 void set_iommu_off(void);
 void set_iommu_bare(void);
@@ -125,6 +181,8 @@ void set_iommu_1lvl(void);
 void set_ig_wsi();
 void set_ig_msi();
 uint32_t rv_iommu_get_ipsr();
+void rv_iommu_dump_state(void);
+void rv_iommu_shadow_sync(void);
 void rv_iommu_clear_ipsr_fip();
 
 /** MSI config table related functions */
@@ -135,7 +193,11 @@ void rv_iommu_set_iosatp_sv39(void);
 void rv_iommu_set_iohgatp_sv39x4(void);
 void rv_iommu_set_iosatp_bare(void);
 void rv_iommu_set_iohgatp_bare(void);
+void rv_iommu_set_msi_off(void);
 void rv_iommu_set_msi_flat(void);
+void rv_iommu_set_multi_tenant(bool enable);
+uint64_t rv_iommu_get_dc_gscid(uint64_t device_id);
+uint64_t rv_iommu_get_dc_pscid(uint64_t device_id);
 
 /** HPM-related functions */
 uint32_t rv_iommu_get_iocountovf();
@@ -149,6 +211,23 @@ uint64_t rv_iommu_get_iohpmevt (size_t counter_idx);
 void rv_iommu_set_iohpmevt(uint64_t iohpmevt_new, size_t counter_idx);
 
 /** Debug interface */
+struct rv_iommu_dbg_req {
+    uint64_t iova;
+    uint64_t device_id;
+    uint64_t process_id;    // Used if pv is set
+    bool pv;
+    bool priv;
+    bool rw;                // Write access (NW clear)
+    bool exe;
+};
+
+struct rv_iommu_dbg_resp {
+    bool fault;
+    bool superpage;
+    uint64_t ppn;           // Superpages are NAPOT-encoded (see rv_iommu_dbg_ppn_encode_x())
+};
+
+bool rv_iommu_dbg_translate(const struct rv_iommu_dbg_req *req, struct rv_iommu_dbg_resp *resp);
 void rv_iommu_dbg_set_iova(uint64_t iova);
 void rv_iommu_dbg_set_did(uint64_t device_id);
 void rv_iommu_dbg_set_pv(bool pv);
@@ -173,6 +252,7 @@ void rv_iommu_iotinval_vma(bool av, bool gv, bool pscv, uint64_t addr, uint64_t
 void rv_iommu_iotinval_gvma(bool av, bool gv, uint64_t addr, uint64_t gscid);
 void rv_iommu_iofence_c(bool wsi, bool av);
 uint32_t rv_iommu_get_iofence(void);
+void rv_iommu_cq_sync(void);
 
 /** fault-Queue-related functions */
 int rv_iommu_fq_read_record(uint64_t *buf);
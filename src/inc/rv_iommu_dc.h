@@ -36,6 +36,9 @@ typedef struct ddt{
 #define IOHGATP_MODE_BARE   (0x0ULL << 60)
 #define IOHGATP_MODE_SV39X4 (0x8ULL << 60)
 
+#define IOSATP_MODE_MASK    (0xFULL << 60)
+#define IOHGATP_MODE_MASK   (0xFULL << 60)
+
 // MSI translation mode encoding to configure DC.msiptp
 #define MSIPTP_MODE_OFF     (0x0ULL << 60)
 #define MSIPTP_MODE_FLAT    (0x1ULL << 60)
@@ -62,6 +65,9 @@ typedef struct ddt{
 #define GSCID_OFF       (44)
 #define PSCID_OFF       (12)
 
+// Tenant to which a device belongs in multi-tenant mode
+#define TENANT_OF(did)  ((did) % N_TENANTS)
+
 // Device Context Indexes
 enum test_dc {
     INVALID,
@@ -80,5 +86,10 @@ enum test_dc {
 extern uint64_t test_dc_tc_table[];
 extern uint64_t GSCID_ARRAY[];
 extern uint64_t PSCID_ARRAY[];
+extern uint64_t TENANT_GSCID_ARRAY[];
+extern uint64_t TENANT_PSCID_ARRAY[];
+extern ddt_t root_ddt[];
+
+void ddt_init(void);
 
 #endif  /* DEVICE_CONTEXTS_H */
\ No newline at end of file
@@ -16,6 +16,13 @@
 #define HPM_S1_PTW      (0x7ULL)
 #define HPM_S2_PTW      (0x8ULL)
 
+// Event counters (iohpmctr index) programmed in init_iommu()
+#define HPM_CTR_UT_REQ      (0)
+#define HPM_CTR_IOTLB_MISS  (1)
+#define HPM_CTR_DDTW        (2)
+#define HPM_CTR_S1_PTW      (3)
+#define HPM_CTR_S2_PTW      (4)
+
 // iohpmevt fields
 #define IOHPMEVT_DMASK          (1ULL << 15)
 #define IOHPMEVT_PID_PSCID_OFF  (16)
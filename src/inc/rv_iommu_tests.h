@@ -43,6 +43,13 @@
 // Number of mappings (PTEs) used for the latency test
 #define N_MAPPINGS          (32)
 
+// Number of tenants (VMs) simulated in multi-tenant mode.
+// Device i is assigned to tenant (i % N_TENANTS). Must match TENANT_GSCID_ARRAY/TENANT_PSCID_ARRAY
+#define N_TENANTS           (4)
+
+// Number of 4-kiB pages touched by each tenant in the scoped-invalidation benchmark
+#define MT_PAGES_PER_TENANT (4)
+
 typedef uint64_t pte_t;
 
 #endif /* IOMMU_TESTS_H */
\ No newline at end of file
@@ -9,6 +9,9 @@
 #include <csrs.h>
 #include <instructions.h>
 #include <platform.h>
+#include <log.h>
+#include <mmio_trace.h>
+#include <mmio_stats.h>
 
 #define STR_HELPER(x) #x
 #define STR(x) STR_HELPER(x)
@@ -22,8 +25,25 @@
 #endif
 
 /**
- *  Colors of log messages 
+ *  Format of test and benchmark results
  */
+#define OUTPUT_TEXT     (0)     // Human-readable text
+#define OUTPUT_CSV      (1)     // One CSV record per line: type,test,name,value,unit
+#define OUTPUT_JSON     (2)     // One JSON object per line
+
+/**
+ *  OUTPUT_FMT should be passed through MAKE.
+ *  Default value of OUTPUT_TEXT is defined
+ */
+#ifndef OUTPUT_FMT
+#define OUTPUT_FMT  OUTPUT_TEXT
+#endif
+
+/**
+ *  Colors of log messages.
+ *  Disabled with structured output, so records can be parsed from the UART log
+ */
+#if OUTPUT_FMT == OUTPUT_TEXT
 #define CDFLT  "\x1B[0m"
 #define CRED  "\x1B[31m"
 #define CGRN  "\x1B[32m"
@@ -32,6 +52,16 @@
 #define CMAG  "\x1B[35m"
 #define CCYN  "\x1B[36m"
 #define CWHT  "\x1B[37m"
+#else
+#define CDFLT  ""
+#define CRED  ""
+#define CGRN  ""
+#define CYEL  ""
+#define CBLU  ""
+#define CMAG  ""
+#define CCYN  ""
+#define CWHT  ""
+#endif
 
 /**
  *  Level of log messages
@@ -44,50 +74,60 @@
 #define LOG_VERBOSE   (5)
 #define LOG_DEBUG     (6)
 
+// Print a log message with a prefix. With LOG_BUFFER, the message is stored in the log ring
+// buffer and formatted when the buffer is flushed, keeping printf out of measured sections
+#if LOG_BUFFER
+# define LOG_PRINT(prefix, str...)	{ log_buf_push(LOG_NARGS(str), prefix str); }
+#else
+# define LOG_PRINT(prefix, str...)	{ printf(prefix str); printf("\n"); }
+#endif
+
 // Define macro to print error logs, function name and source code line. Then exit normally and freeze execution.
 // If log level is lower than error, don't print anything. Simply exit with -1 and freeze execution.
 #if LOG_LEVEL >= LOG_ERROR
 # define ERROR(str...)	{\
     printf(CRED "ERROR: " CDFLT str );\
     printf(" (%s, %d)\n", __func__, __LINE__);\
+    MMIO_TRACE_DUMP("error");\
+    LOG_FLUSH();\
     exit(0);\
     while(1);\
 }
 #else
-# define ERROR(...) { exit(-1); while(1); }
+# define ERROR(...) { MMIO_TRACE_DUMP("error"); LOG_FLUSH(); exit(-1); while(1); }
 #endif
 
 // Define macro to print info logs if sufficient log level
 #if LOG_LEVEL >= LOG_INFO
-# define INFO(str...)	{ printf(str); printf("\n"); }
+# define INFO(str...)	LOG_PRINT("", str)
 #else
 # define INFO(...)
 #endif
 
 // Define macro to print detail logs if sufficient log level
 #if LOG_LEVEL >= LOG_DETAIL
-# define DETAIL(str...)	{ printf(str); printf("\n"); }
+# define DETAIL(str...)	LOG_PRINT("", str)
 #else
 # define DETAIL(...)
 #endif
 
 // Define macro to print warning logs if sufficient log level
 #if LOG_LEVEL >= LOG_WARNING
-# define WARN(str...)	{ printf(CYEL "WARNING: " CDFLT str); printf("\n"); }
+# define WARN(str...)	LOG_PRINT(CYEL "WARNING: " CDFLT, str)
 #else
 # define WARN(...)
 #endif
 
 // Define macro to print verbose logs if sufficient log level
 #if LOG_LEVEL >= LOG_VERBOSE
-# define VERBOSE(str...)	{ printf("VERBOSE: " str); printf("\n"); }
+# define VERBOSE(str...)	LOG_PRINT("VERBOSE: ", str)
 #else
 # define VERBOSE(...)
 #endif
 
 // Define macro to print debug logs if sufficient log level
 #if LOG_LEVEL >= LOG_DEBUG
-# define DEBUG(str...)	{ printf("DEBUG: " str); printf("\n"); }
+# define DEBUG(str...)	LOG_PRINT("DEBUG: ", str)
 #else
 # define DEBUG(...)
 #endif
@@ -122,25 +162,55 @@ extern struct exception {
 } excpt;
 
 typedef bool (*test_func_t)();
-extern test_func_t* test_table;
+typedef void (*irq_handler_t)(void);
+
+/**
+ *  Descriptor of a registered test: name, comma-separated list of tags and test function
+ */
+struct test_desc {
+    const char *name;
+    const char *tags;
+    test_func_t func;
+};
+
+extern const struct test_desc** test_table;
 extern size_t test_table_size;
 
+/**
+ *  Comma-separated list of test names and tags to run. Tokens prefixed with '-' exclude
+ *  the matching tests. TEST_SELECT should be passed through MAKE (TESTS variable), and is
+ *  overridden at boot if fromhost holds the address of a selection string.
+ *  By default, only the architectural tests are run
+ */
+#ifndef TEST_SELECT
+#define TEST_SELECT     "arch"
+#endif
+
+bool test_selected(const struct test_desc *test, const char *sel);
+
 // Print the name of the current test (function)
 // Declare test status with default value of true
 #define TEST_START()\
     const char* __test_name = __func__;\
     bool test_status = true;\
-    if(LOG_LEVEL >= LOG_INFO) printf(CBLU "%-70s" CDFLT, __test_name);\
-    if(LOG_LEVEL >= LOG_DETAIL) printf("\n");
-
-// section key places the function code in the specified section (.test_table)
-// used key is used to generate code for the function even if it is not referenced
-#define TEST_REGISTER(test)\
+    if(OUTPUT_FMT == OUTPUT_TEXT && LOG_LEVEL >= LOG_INFO) printf(CBLU "%-70s" CDFLT, __test_name);\
+    if(OUTPUT_FMT == OUTPUT_TEXT && LOG_LEVEL >= LOG_DETAIL) printf("\n");\
+    MMIO_STATS_BEGIN();
+
+// section key places a pointer to the test descriptor in the specified section (.test_table)
+// used key is used to generate code for the function even if it is not referenced.
+// tags is a string with a comma-separated list of tags used to select the test
+#define TEST_REGISTER(test, tags)\
     bool test();\
-    static test_func_t test ## func __attribute__((section(".test_table"), used)) = test;
+    static const struct test_desc test ## desc = {#test, tags, test};\
+    static const struct test_desc* test ## func __attribute__((section(".test_table"), used)) = &test ## desc;
 
 #define TEST_ASSERT(test, cond, ...) {\
-    if(LOG_LEVEL >= LOG_DETAIL){\
+    if(OUTPUT_FMT != OUTPUT_TEXT){\
+        num_total_tests++;\
+        if(cond) {num_succ_tests++;};\
+        output_record("assert", __test_name, test, (cond) ? "1" : "0", "pass");\
+    } else if(LOG_LEVEL >= LOG_DETAIL){\
         size_t line_size = 60;\
         size_t size = strlen(test);\
         printf(CBLU "\t%-70.*s" CDFLT, line_size, test);\
@@ -188,9 +258,14 @@ extern size_t test_table_size;
 // Reset CPU by writing 
 #define TEST_END(test) {\
 failed:\
-    if(LOG_LEVEL >= LOG_INFO && LOG_LEVEL < LOG_VERBOSE){\
+    if(OUTPUT_FMT != OUTPUT_TEXT){\
+        output_record("test", __test_name, "", (test_status) ? "1" : "0", "pass");\
+    } else if(LOG_LEVEL >= LOG_INFO && LOG_LEVEL < LOG_VERBOSE){\
          printf("%s\n" CDFLT, (test_status) ? CGRN "PASSED" : CRED "FAILED");\
     }\
+    MMIO_TRACE_DUMP(__test_name);\
+    MMIO_STATS_REPORT(__test_name);\
+    LOG_FLUSH();\
     goto_priv(PRIV_M);\
     reset_state();\
     return (test_status);\
@@ -244,21 +319,30 @@ failed:\
 }
 
 #define END(){\
-    if (num_succ_tests == num_total_tests) { \
+    if (OUTPUT_FMT != OUTPUT_TEXT) { \
+        output_summary(num_succ_tests, num_total_tests); \
+    } else if (num_succ_tests == num_total_tests) { \
         printf(CGRN "Summary: passed %d of %d\n", num_succ_tests, num_total_tests); \
     } else { \
         printf(CRED "Summary: failed %d of %d\n", num_total_tests-num_succ_tests, num_total_tests); \
     } \
+    MMIO_TRACE_DUMP("end");\
+    MMIO_STATS_REPORT_TOTAL();\
     printf(CBLU "You can close the test!\n"); \
+    LOG_FLUSH();\
     exit(0);\
 }
 
 static inline uint64_t read64(uintptr_t addr){
-    return *((volatile uint64_t*) addr);
+    uint64_t val = *((volatile uint64_t*) addr);
+    MMIO_TRACE_ACCESS(addr, val, 8, false);
+    return val;
 }
 
 static inline uint32_t read32(uintptr_t addr){
-    return *((volatile uint32_t*) addr);
+    uint32_t val = *((volatile uint32_t*) addr);
+    MMIO_TRACE_ACCESS(addr, val, 4, false);
+    return val;
 }
 
 static inline uint16_t read16(uintptr_t addr){
@@ -270,10 +354,12 @@ static inline uint8_t read8(uintptr_t addr){
 }
 
 static inline void write64(uintptr_t addr, uint64_t val){
+    MMIO_TRACE_ACCESS(addr, val, 8, true);
     *((volatile uint64_t*) addr) = val;
 }
 
 static inline void write32(uintptr_t addr, uint32_t val){
+    MMIO_TRACE_ACCESS(addr, val, 4, true);
     *((volatile uint32_t*) addr) = val;
 }
 
@@ -285,7 +371,19 @@ static inline void write8(uintptr_t addr, uint8_t val){
     *((volatile uint8_t*) addr) = val;    
 }
 
+// Count the MMIO accesses of each call site. Parentheses around the name call the
+// functions above instead of expanding the macros
+#if MMIO_STATS
+# define read64(addr)   ({ uintptr_t __mmio_addr = (uintptr_t)(addr); MMIO_STATS_ACCESS(__mmio_addr, 0); (read64)(__mmio_addr); })
+# define read32(addr)   ({ uintptr_t __mmio_addr = (uintptr_t)(addr); MMIO_STATS_ACCESS(__mmio_addr, 0); (read32)(__mmio_addr); })
+# define write64(addr, val) ({ uintptr_t __mmio_addr = (uintptr_t)(addr); MMIO_STATS_ACCESS(__mmio_addr, 1); (write64)(__mmio_addr, (val)); })
+# define write32(addr, val) ({ uintptr_t __mmio_addr = (uintptr_t)(addr); MMIO_STATS_ACCESS(__mmio_addr, 1); (write32)(__mmio_addr, (val)); })
+#endif
+
+void output_record(const char *type, const char *test, const char *name, const char *value, const char *unit);
+void output_summary(uint32_t succ, uint32_t total);
 void reset_state();
+void set_m_irq_handler(uint64_t cause, irq_handler_t handler);
 void set_prev_priv(int target_priv);
 void goto_priv(int target_priv);
 
@@ -0,0 +1,44 @@
+#ifndef WAIT_H
+#define WAIT_H
+
+#include <rvh_test.h>
+
+// Default cycle budget of a wait. Conditions not met within the budget are treated as hangs
+#ifndef WAIT_BUDGET
+#define WAIT_BUDGET     (100000000ULL)
+#endif
+
+/**
+ *  Wait site: identifies a WAIT_UNTIL invocation and accumulates its time-to-condition.
+ *  Sites are placed in the .wait_sites section, so all of them can be reported
+ */
+struct wait_site {
+    const char *what;
+    const char *func;
+    uint32_t line;
+    uint64_t count;
+    uint64_t sum;
+    uint64_t max;
+};
+
+// Spin until cond is true, for at most budget cycles. Evaluates to the number of cycles waited.
+// On timeout, the IOMMU state is dumped and the execution is aborted with ERROR
+#define WAIT_UNTIL(cond, budget, what_str) ({\
+    static struct wait_site __wait_site __attribute__((section(".wait_sites"), used)) =\
+        {.what = what_str, .func = __func__, .line = __LINE__};\
+    uint64_t __wait_start = CSRR(CSR_CYCLES);\
+    uint64_t __wait_cycles;\
+    while (!(cond)) {\
+        if ((CSRR(CSR_CYCLES) - __wait_start) > (budget))\
+            wait_timeout(&__wait_site, CSRR(CSR_CYCLES) - __wait_start);\
+    }\
+    __wait_cycles = CSRR(CSR_CYCLES) - __wait_start;\
+    wait_record(&__wait_site, __wait_cycles);\
+    __wait_cycles;\
+})
+
+void wait_record(struct wait_site *site, uint64_t cycles);
+void wait_timeout(struct wait_site *site, uint64_t cycles);
+void wait_report(void);
+
+#endif /* WAIT_H */
@@ -0,0 +1,55 @@
+#ifndef WORKLOAD_H
+#define WORKLOAD_H
+
+#include <rv_iommu_tests.h>
+
+// Maximum working set size (pages) and number of devices of a workload
+#define WL_MAX_PAGES        (4096)
+#define WL_MAX_DEVICES      (16)
+
+// Default PRNG seed. Runs with the same seed and configuration generate the same access sequence
+#ifndef WL_SEED
+#define WL_SEED             (0x9E3779B97F4A7C15ULL)
+#endif
+
+enum wl_pattern {
+    WL_SEQUENTIAL,      // Pages 0, 1, 2, ... (wraps around)
+    WL_STRIDED,         // Pages 0, s, 2s, ... (modulo working set size)
+    WL_UNIFORM,         // Uniform random pages
+    WL_ZIPF,            // Zipfian ranks (p(k) ~ 1/k^s), mapped to pages through a random permutation
+    WL_PHASED,          // Uniform random pages within a window that moves every phase_len accesses
+    WL_PATTERN_MAX
+};
+
+extern const char* wl_pattern_strs[];
+
+struct workload_cfg {
+    enum wl_pattern pattern;
+    size_t n_pages;         // Working set size, in pages (<= WL_MAX_PAGES)
+    size_t stride;          // WL_STRIDED: stride, in pages
+    unsigned zipf_s;        // WL_ZIPF: integer exponent (1 for classic Zipf)
+    size_t phase_len;       // WL_PHASED: accesses per phase
+    size_t phase_pages;     // WL_PHASED: working set size of each phase, in pages
+    size_t n_devices;       // Number of devices issuing accesses (<= WL_MAX_DEVICES)
+    const uint32_t *device_weights; // Relative weight of each device (NULL for uniform)
+    uint64_t seed;          // PRNG seed (0 selects WL_SEED)
+};
+
+struct wl_access {
+    size_t device;          // Device index in [0, n_devices)
+    size_t page;            // Page index in [0, n_pages)
+};
+
+struct workload {
+    struct workload_cfg cfg;
+    uint64_t rng;
+    uint64_t n_access;
+    size_t phase_base;
+    uint32_t dev_cdf[WL_MAX_DEVICES];
+};
+
+uint64_t wl_rand(uint64_t *state);
+void workload_init(struct workload *wl, const struct workload_cfg *cfg);
+void workload_next(struct workload *wl, struct wl_access *acc);
+
+#endif /* WORKLOAD_H */
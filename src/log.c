@@ -0,0 +1,172 @@
+#include <log.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+
+/**
+ *  Log ring buffer. Each record starts with a header word followed by its payload:
+ *  -   Message: format string pointer and number of arguments, followed by the arguments.
+ *      Formatting is deferred to the flush, so logging only costs a few stores
+ *  -   Text: length of the text, followed by the text (console output captured from _write)
+ */
+#define LOG_REC_TEXT        (1ULL << 63)
+#define LOG_REC_NARGS_OFF   (48)
+#define LOG_REC_NARGS_MASK  (0xFULL << LOG_REC_NARGS_OFF)
+#define LOG_REC_PTR_MASK    ((1ULL << LOG_REC_NARGS_OFF) - 1)
+
+static uint64_t log_buf[LOG_BUF_WORDS];
+static size_t log_head;
+static size_t log_tail;
+
+// Maximum length of a formatted log message
+#define LOG_LINE_LEN        (256)
+
+// True while the ring is being flushed. Console output goes directly to the UART
+static bool log_flushing;
+
+// Number of flushes forced by a full ring (possibly within a measured section)
+static uint32_t log_forced_flushes;
+
+// Console output function of the platform
+extern int _write(int file, char *ptr, int len);
+
+/**
+ *  Format and print all records in the ring through _write.
+ *  stdio is not used, so the ring can be drained while capturing console output
+ */
+static void log_drain(void)
+{
+    char line[LOG_LINE_LEN];
+
+    log_flushing = true;
+
+    while (log_head != log_tail)
+    {
+        uint64_t hdr = log_buf[log_head % LOG_BUF_WORDS];
+        log_head++;
+
+        if (hdr & LOG_REC_TEXT)
+        {
+            size_t len = hdr & ~LOG_REC_TEXT;
+
+            for (size_t i = 0; i < len; i += sizeof(uint64_t))
+            {
+                uint64_t word = log_buf[log_head % LOG_BUF_WORDS];
+                log_head++;
+                _write(1, (char*)&word, ((len - i) < sizeof(uint64_t)) ? (len - i) : (sizeof(uint64_t)));
+            }
+        }
+        else
+        {
+            uint64_t args[LOG_MAX_ARGS] = {0};
+            size_t nargs = (hdr & LOG_REC_NARGS_MASK) >> LOG_REC_NARGS_OFF;
+
+            for (size_t i = 0; i < nargs; i++)
+            {
+                args[i] = log_buf[log_head % LOG_BUF_WORDS];
+                log_head++;
+            }
+
+            // Unused arguments are ignored
+            int len = snprintf(line, sizeof(line), (const char*)(uintptr_t)(hdr & LOG_REC_PTR_MASK),
+                                args[0], args[1], args[2], args[3], args[4], args[5], args[6], args[7]);
+            len = (len >= (int)sizeof(line)) ? ((int)sizeof(line) - 1) : (len);
+
+            _write(1, line, len);
+            _write(1, "\n", 1);
+        }
+    }
+
+    log_flushing = false;
+}
+
+/**
+ *  Reserve n words in the ring. A full ring is drained first
+ */
+static void log_buf_reserve(size_t n)
+{
+    if ((LOG_BUF_WORDS - (log_tail - log_head)) < n)
+    {
+        log_forced_flushes++;
+        log_drain();
+    }
+}
+
+static inline void log_buf_put(uint64_t word)
+{
+    log_buf[log_tail % LOG_BUF_WORDS] = word;
+    log_tail++;
+}
+
+/**
+ *  Store a log message with nargs integer/pointer arguments.
+ *  Arguments are read as 64-bit values: in the RV64 calling convention, every variadic
+ *  argument takes a full register/stack slot, so narrower integers are printed correctly
+ */
+void log_buf_push(size_t nargs, const char *fmt, ...)
+{
+    va_list args;
+
+    // Keep the order with console output pending in the stdio buffer
+    fflush(stdout);
+
+    nargs = (nargs > LOG_MAX_ARGS) ? (LOG_MAX_ARGS) : (nargs);
+    log_buf_reserve(nargs + 1);
+
+    log_buf_put(((uintptr_t)fmt & LOG_REC_PTR_MASK) | ((uint64_t)nargs << LOG_REC_NARGS_OFF));
+
+    va_start(args, fmt);
+    for (size_t i = 0; i < nargs; i++)
+        log_buf_put(va_arg(args, uint64_t));
+    va_end(args);
+}
+
+/**
+ *  Store console output in the ring. Returns false if the output must be sent to the UART
+ */
+bool log_buf_capture(const char *ptr, size_t len)
+{
+    if (log_flushing)
+        return false;
+
+    size_t n_words = (len + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+    // Text larger than the ring is not buffered
+    if (n_words + 1 > LOG_BUF_WORDS)
+    {
+        log_drain();
+        return false;
+    }
+
+    log_buf_reserve(n_words + 1);
+    log_buf_put(LOG_REC_TEXT | len);
+
+    for (size_t i = 0; i < len; i += sizeof(uint64_t))
+    {
+        uint64_t word = 0;
+        memcpy(&word, &ptr[i], ((len - i) < sizeof(uint64_t)) ? (len - i) : (sizeof(uint64_t)));
+        log_buf_put(word);
+    }
+
+    return true;
+}
+
+/**
+ *  Print all buffered output. Must be called outside measured sections
+ */
+void log_flush(void)
+{
+    // Pending stdio output is captured in the ring first
+    fflush(stdout);
+    log_drain();
+
+    if (log_forced_flushes)
+    {
+        char line[LOG_LINE_LEN];
+        int len = snprintf(line, sizeof(line), "WARNING: log buffer full, flushed %u times\n", log_forced_flushes);
+        log_flushing = true;
+        _write(1, line, len);
+        log_flushing = false;
+        log_forced_flushes = 0;
+    }
+}
@@ -1,19 +1,52 @@
 #include <rvh_test.h>
 #include <rv_iommu.h>
+#include <wait.h>
+#include <boot.h>
+#include <hart.h>
+
+// Written by the host before boot with the address of a test selection string (0 if unused)
+extern volatile uint64_t fromhost;
 
 void main(){
 
     INFO("RISC-V Input/Output Memory Management Unit Tests");
 
     // Reset CPU
+    boot_phase("reset_state");
     reset_state();
-    // Init IOMMU with basic configuration
+    // Bring up the secondary harts
+    boot_phase("harts");
+    harts_release();
+    // Init IOMMU with basic configuration (phases marked in init_iommu)
     init_iommu();
+    // Save the initial IOMMU state, restored after each test
+    boot_phase("snapshot");
+    rv_iommu_snapshot();
+
+    // Per-phase startup time, to compare builds (e.g., with and without STATIC_TABLES)
+    boot_report();
+    MMIO_TRACE_DUMP("boot");
+    MMIO_STATS_REPORT("boot");
+
+    // The host selection overrides the one passed through MAKE
+    const char *sel = (fromhost != 0) ? ((const char*)fromhost) : (TEST_SELECT);
+    VERBOSE("Test selection: %s", sel);
 
     // Test functions are manually assigned to the .test_table 
     // section in the test_register.c file using the TEST_REGISTER macro
     for(int i = 0; i < test_table_size; i++)
-        test_table[i]();
+    {
+        if (!test_selected(test_table[i], sel))
+            continue;
+
+        test_table[i]->func();
+
+        size_t n_restored = rv_iommu_restore();
+        VERBOSE("IOMMU state restored (%lu words)", n_restored);
+        MMIO_TRACE_DUMP("restore");
+    }
+
+    wait_report();
 
     END();
 }
@@ -0,0 +1,105 @@
+#include <mmio_stats.h>
+#include <bench.h>
+
+// Access sites are manually assigned to the .mmio_sites section by the MMIO_STATS_ACCESS macro
+extern struct mmio_site _mmio_sites, _mmio_sites_end;
+
+/**
+ *  Start counting the accesses of a test
+ */
+void mmio_stats_begin(void)
+{
+    for (struct mmio_site *site = &_mmio_sites; site < &_mmio_sites_end; site++)
+    {
+        site->mark[0] = site->n[0];
+        site->mark[1] = site->n[1];
+    }
+}
+
+/**
+ *  Print the MMIO reads and writes of each function since the last mmio_stats_begin()
+ *  (or since boot if total is set), most accessing functions first.
+ *  Sites of the same function in different translation units (inline helpers) are merged.
+ *  Structured output includes functions with no accesses, so each run reports the same metrics
+ */
+void mmio_stats_report(const char *name, bool total)
+{
+    static struct {
+        const char *func;
+        uint64_t n[2];
+    } funcs[MMIO_STATS_FUNCS];
+    size_t n_funcs = 0;
+    uint64_t n_total[2] = {0, 0};
+
+    //# Aggregate per function
+    for (struct mmio_site *site = &_mmio_sites; site < &_mmio_sites_end; site++)
+    {
+        uint64_t rd = site->n[0] - ((total) ? (0) : (site->mark[0]));
+        uint64_t wr = site->n[1] - ((total) ? (0) : (site->mark[1]));
+        if (rd + wr == 0 && OUTPUT_FMT == OUTPUT_TEXT)
+            continue;
+
+        size_t f = 0;
+        while (f < n_funcs && strcmp(funcs[f].func, site->func) != 0)
+            f++;
+
+        if (f == n_funcs)
+        {
+            if (n_funcs == MMIO_STATS_FUNCS)
+                {ERROR("MMIO_STATS_FUNCS exceeded")}
+            funcs[f].func = site->func;
+            funcs[f].n[0] = funcs[f].n[1] = 0;
+            n_funcs++;
+        }
+
+        funcs[f].n[0] += rd;
+        funcs[f].n[1] += wr;
+        n_total[0] += rd;
+        n_total[1] += wr;
+    }
+
+    if (n_total[0] + n_total[1] == 0 && OUTPUT_FMT == OUTPUT_TEXT)
+        return;
+
+    //# Sort by number of accesses (insertion sort, few functions)
+    for (size_t i = 1; i < n_funcs; i++)
+    {
+        for (size_t j = i; j > 0 && (funcs[j].n[0] + funcs[j].n[1]) > (funcs[j-1].n[0] + funcs[j-1].n[1]); j--)
+        {
+            typeof(funcs[0]) tmp = funcs[j];
+            funcs[j] = funcs[j-1];
+            funcs[j-1] = tmp;
+        }
+    }
+
+    //# Structured output reports all functions with a site, so metrics can be compared across runs
+    if (OUTPUT_FMT != OUTPUT_TEXT)
+    {
+        bench_report(name, "accesses", n_total[0], "mmio.reads");
+        bench_report(name, "accesses", n_total[1], "mmio.writes");
+        for (size_t f = 0; f < n_funcs; f++)
+        {
+            bench_report(name, "accesses", funcs[f].n[0], "mmio.%s.reads", funcs[f].func);
+            bench_report(name, "accesses", funcs[f].n[1], "mmio.%s.writes", funcs[f].func);
+        }
+    }
+    else if (LOG_LEVEL >= LOG_INFO)
+    {
+        printf("\tMMIO accesses (%s): %llu reads, %llu writes\n", name, n_total[0], n_total[1]);
+        for (size_t f = 0; f < n_funcs && f < MMIO_STATS_TOP; f++)
+            printf("\t\t%-48s %8llu %8llu\n", funcs[f].func, funcs[f].n[0], funcs[f].n[1]);
+    }
+}
+
+/**
+ *  Returns the number of MMIO accesses counted since boot (0 without MMIO_STATS)
+ */
+uint64_t mmio_stats_count(void)
+{
+    uint64_t n = 0;
+
+    for (struct mmio_site *site = &_mmio_sites; site < &_mmio_sites_end; site++)
+        n += __atomic_load_n(&site->n[0], __ATOMIC_RELAXED) + __atomic_load_n(&site->n[1], __ATOMIC_RELAXED);
+
+    return n;
+}
@@ -0,0 +1,57 @@
+#include <mmio_trace.h>
+#include <rvh_test.h>
+
+struct mmio_trace_entry {
+    uint64_t cycle;
+    uint64_t val;
+    uint32_t off;       // Offset w.r.t. MMIO_TRACE_BASE
+    uint8_t size;
+    bool write;
+};
+
+static struct mmio_trace_entry trace[MMIO_TRACE_ENTRIES];
+
+// Number of accesses recorded since the last dump (including overwritten ones)
+static uint64_t trace_n = 0;
+
+void mmio_trace_record(uintptr_t addr, uint64_t val, uint8_t size, bool write)
+{
+    // Atomic, since secondary harts may issue MMIO accesses concurrently
+    uint64_t n = __atomic_fetch_add(&trace_n, 1, __ATOMIC_RELAXED);
+    struct mmio_trace_entry *e = &trace[n % MMIO_TRACE_ENTRIES];
+
+    e->cycle = CSRR(CSR_CYCLES);
+    e->val = val;
+    e->off = (uint32_t)(addr - MMIO_TRACE_BASE);
+    e->size = size;
+    e->write = write;
+}
+
+/**
+ *  Print the accesses recorded since the last dump and reset the trace.
+ *  One line per access: cycles since the previous access, direction and size, offset and value (hex).
+ *  The first access of a dump has an absolute timestamp
+ */
+void mmio_trace_dump(const char *name)
+{
+    uint64_t n = trace_n;
+    uint64_t first = (n > MMIO_TRACE_ENTRIES) ? (n - MMIO_TRACE_ENTRIES) : (0);
+    uint64_t prev = 0;
+
+    if (n == 0)
+        return;
+
+    printf("MMIO_TRACE %s %llu %llu %llx\n", name, n - first, first, (uint64_t)MMIO_TRACE_BASE);
+
+    for (uint64_t i = first; i < n; i++)
+    {
+        struct mmio_trace_entry *e = &trace[i % MMIO_TRACE_ENTRIES];
+
+        printf("%llx %c%u %x %llx\n", e->cycle - prev, (e->write) ? ('w') : ('r'), e->size, e->off, e->val);
+        prev = e->cycle;
+    }
+
+    printf("MMIO_TRACE_END\n");
+
+    trace_n = 0;
+}
@@ -56,16 +56,29 @@ struct {
     [PT_TOP]            =   {PTE_V | PTE_RWX,           PTE_V | PTE_U | PTE_RWX},
 };      
 
+// Per-tenant root tables used in multi-tenant mode (first-stage Sv39 and second-stage Sv39x4)
+pte_t s1pt_tenant_root[N_TENANTS][PAGE_SIZE/sizeof(pte_t)] __attribute__((aligned(PAGE_SIZE)));
+pte_t s2pt_tenant_root[N_TENANTS][PAGE_SIZE*4/sizeof(pte_t)] __attribute__((aligned(PAGE_SIZE*4)));
+
+// With STATIC_TABLES, the tables below are defined in the file generated by tools/gen_tables.c
+#if (STATIC_TABLES == 0)
 // 6x512 PTEs
-pte_t s1pt[6][PAGE_SIZE/sizeof(pte_t)] __attribute__((aligned(PAGE_SIZE)));
+pte_t s1pt[S1PT_N_TABLES][PAGE_SIZE/sizeof(pte_t)] __attribute__((aligned(PAGE_SIZE)));
 // Root table (Sv39x4) (2048 PTEs pointing to 16-kiB pages)
 pte_t s2pt_root[PAGE_SIZE*4/sizeof(pte_t)] __attribute__((aligned(PAGE_SIZE*4)));
 // n-level tables (5x512 PTEs pointing to 4-kiB pages)
-pte_t s2pt[5][PAGE_SIZE/sizeof(pte_t)] __attribute__((aligned(PAGE_SIZE)));
+pte_t s2pt[S2PT_N_TABLES][PAGE_SIZE/sizeof(pte_t)] __attribute__((aligned(PAGE_SIZE)));
 // 32 MSI PTEs, each PTE is 16-bytes, base address aligned to 4-kiB
 uint64_t msi_pt[MSI_N_ENTRIES * 2] __attribute__((aligned(PAGE_SIZE)));
 // MRIF
-uint64_t mrif[64] __attribute__((aligned(512)));
+uint64_t mrif[MRIF_N_DWORDS] __attribute__((aligned(512)));
+// Benchmark window tables: one second-level table followed by BENCH_N_PT leaf tables (per stage)
+pte_t s1pt_bench[1+BENCH_N_PT][PAGE_SIZE/sizeof(pte_t)] __attribute__((aligned(PAGE_SIZE)));
+pte_t s2pt_bench[1+BENCH_N_PT][PAGE_SIZE/sizeof(pte_t)] __attribute__((aligned(PAGE_SIZE)));
+// Benchmark window tables with 2-MiB PTEs (per stage)
+pte_t s1pt_bench_2mib[PAGE_SIZE/sizeof(pte_t)] __attribute__((aligned(PAGE_SIZE)));
+pte_t s2pt_bench_2mib[PAGE_SIZE/sizeof(pte_t)] __attribute__((aligned(PAGE_SIZE)));
+#endif
 
 /**
  *  Setup first-stage PTEs
@@ -165,6 +178,51 @@ void s1pt_init(){
              PTE_V | PTE_AD | PTE_RWX;  
         addr +=  SUPERPAGE_SIZE(1);
     }
+
+    // Setup non-leaf entry pointing to the second-level table of the benchmark window
+    s1pt[0][6] = 
+        PTE_V | ((((uintptr_t)&s1pt_bench[0][0]) >> 2) & PTE_PPN_MSK);
+
+    // Clear second-level table entries
+    for(int i = 0; i < 512; i++) s1pt_bench[0][i] = 0;
+
+    addr = BENCH_VADDR_BASE;
+
+    //# Fill BENCH_N_PT leaf tables with 4-kiB PTEs (GVA == GPA)
+    for(int j = 0; j < BENCH_N_PT; j++){
+        s1pt_bench[0][j] = 
+            PTE_V | ((((uintptr_t)&s1pt_bench[1+j][0]) >> 2) & PTE_PPN_MSK);
+
+        for(int i = 0; i < 512; i++){
+            s1pt_bench[1+j][i] = (addr >> 2) | PTE_AD |
+                PTE_V | PTE_U | PTE_RWX;
+            addr +=  PAGE_SIZE;
+        }
+    }
+
+    // Setup non-leaf entry pointing to the 2-MiB table of the benchmark window
+    s1pt[0][7] = 
+        PTE_V | ((((uintptr_t)&s1pt_bench_2mib[0]) >> 2) & PTE_PPN_MSK);
+
+    // Clear table entries
+    for(int i = 0; i < 512; i++) s1pt_bench_2mib[i] = 0;
+
+    addr = BENCH_VADDR_2MIB_BASE;
+
+    //# Fill BENCH_N_SUPERPAGES leaf 2MiB PTEs (GVA == GPA)
+    for(int i = 0; i < BENCH_N_SUPERPAGES; i++){
+        s1pt_bench_2mib[i] = 
+            STAGE1_PERM_2MIB | (addr >> 2);
+        addr +=  SUPERPAGE_SIZE(1);
+    }
+
+    //# First-stage-only aliases of the benchmark window (GVA -> SPA)
+    // Non-leaf entries pointing to the second-stage tables of the window (setup in s2pt_init)
+    s1pt[0][8] = 
+        PTE_V | ((((uintptr_t)&s2pt_bench[0][0]) >> 2) & PTE_PPN_MSK);
+
+    s1pt[0][9] = 
+        PTE_V | ((((uintptr_t)&s2pt_bench_2mib[0]) >> 2) & PTE_PPN_MSK);
 }
 
 /**
@@ -272,6 +330,62 @@ void s2pt_init(){
              PTE_V | PTE_U | PTE_AD | PTE_RWX;  
         addr +=  SUPERPAGE_SIZE(1);
     }
+
+    // Non-leaf entry pointing to the second-level table of the benchmark window
+    s2pt_root[6] =
+        PTE_V | ((((uintptr_t)&s2pt_bench[0][0]) >> 2) & PTE_PPN_MSK);
+
+    // Clear second-level table entries
+    for(int i = 0; i < 512; i++) s2pt_bench[0][i] = 0;
+
+    addr = BENCH_PADDR_BASE;
+
+    //# Fill BENCH_N_PT leaf tables with 4-kiB PTEs (GPA -> contiguous SPA range)
+    for(int j = 0; j < BENCH_N_PT; j++){
+        s2pt_bench[0][j] = 
+            PTE_V | ((((uintptr_t)&s2pt_bench[1+j][0]) >> 2) & PTE_PPN_MSK);
+
+        for(int i = 0; i < 512; i++){
+            s2pt_bench[1+j][i] = (addr >> 2) | PTE_AD |
+                PTE_V | PTE_U | PTE_RWX;
+            addr +=  PAGE_SIZE;
+        }
+    }
+
+    // Non-leaf entry pointing to the 2-MiB table of the benchmark window
+    s2pt_root[7] =
+        PTE_V | ((((uintptr_t)&s2pt_bench_2mib[0]) >> 2) & PTE_PPN_MSK);
+
+    // Clear table entries
+    for(int i = 0; i < 512; i++) s2pt_bench_2mib[i] = 0;
+
+    addr = BENCH_PADDR_BASE;
+
+    //# Fill BENCH_N_SUPERPAGES leaf 2MiB PTEs (GPA -> contiguous SPA range)
+    for(int i = 0; i < BENCH_N_SUPERPAGES; i++){
+        s2pt_bench_2mib[i] = 
+            STAGE2_PERM_2MIB | (addr >> 2);
+        addr +=  SUPERPAGE_SIZE(1);
+    }
+}
+
+/**
+ *  Setup per-tenant root tables.
+ *  Each tenant gets its own copy of the first and second-stage root tables.
+ *  Non-leaf entries still point to the shared lower-level tables, so all tenants
+ *  see the same mappings, but walks start from distinct roots.
+ */
+void tenant_pt_init(){
+
+    for(int t = 0; t < N_TENANTS; t++){
+        for(int i = 0; i < 512; i++)
+            s1pt_tenant_root[t][i] = s1pt[0][i];
+
+        for(int i = 0; i < 2048; i++)
+            s2pt_tenant_root[t][i] = s2pt_root[i];
+    }
+
+    fence_i();
 }
 
 // Swap two 4-kiB PTEs associated with the permission table (first-stage w/ V=1)
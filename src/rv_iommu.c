@@ -1,6 +1,9 @@
 #include <rv_iommu.h>
 #include <rv_iommu_tests.h>
 #include <page_tables.h>
+#include <wait.h>
+#include <boot.h>
+#include <hart.h>
 
 #define TR_REQ_CTL_DID_OFFSET   40
 #define TR_REQ_CTL_DID_MASK     0xFFFFFF0000000000ULL
@@ -18,8 +21,6 @@
 #define TR_RESPONSE_PPN_OFFSET  (10)
 #define TR_RESPONSE_PPN_MASK    (0x3FFFFFFFFFFC00ULL)
 
-#define IOMMU_MAX_MSI_CFG_TABLE 16
-
 typedef struct debug {
   uint64_t tr_req_iova; // translation-request IOVA
   uint64_t tr_req_ctl;  // translation-request control
@@ -64,21 +65,82 @@ typedef struct iommu {
 
 typedef uint64_t command_t[2];
 
+struct rv_iommu rv_iommu_inst[PLAT_N_IOMMU];
+
+/**
+ *  Instance driven by each hart. All driver functions operate on the instance selected
+ *  by the calling hart, so several instances can be driven in parallel from different harts
+ */
+static struct rv_iommu *hart_iommu[PLAT_N_HARTS] = {[0 ... PLAT_N_HARTS - 1] = &rv_iommu_inst[0]};
+
+static inline struct rv_iommu *rv_iommu_cur(void)
+{
+    return hart_iommu[hart_id()];
+}
+
 /** IOMMU hw structure only visible inside IOMMU driver */
-static iommu_t *iommu = (void*)IOMMU_BASE_ADDR;
+static inline iommu_t *rv_iommu_regs(void)
+{
+    return (iommu_t*)rv_iommu_cur()->base;
+}
+
+/**
+ *  Select the IOMMU instance driven by the calling hart
+ */
+void rv_iommu_select(struct rv_iommu *inst)
+{
+    hart_iommu[hart_id()] = inst;
+}
+
+struct rv_iommu *rv_iommu_selected(void)
+{
+    return rv_iommu_cur();
+}
+
+/**
+ *  The driver keeps a copy of the software-owned registers of each instance (rv_iommu->shadow),
+ *  so getters and read-modify-write sequences do not need MMIO reads. Every write through the
+ *  driver updates it. Fields hardware can change are not trusted by the driver:
+ *      - tr_req_ctl.GO is never held in the shadow (cleared by hardware upon completion)
+ *      - iohpmevt.OF is set by hardware upon overflow: rv_iommu_get_iohpmevt() reads the register
+ *      - WARL fields (fctl, icvec, iohpmevt) may hold a legalized value: call rv_iommu_shadow_sync()
+ */
+
+/**
+ *  Reload the register shadow from the IOMMU
+ */
+void rv_iommu_shadow_sync(void)
+{
+    struct iommu_shadow *shadow = &rv_iommu_cur()->shadow;
 
-// N_entries * 16 bytes
-uint64_t command_queue[CQ_N_ENTRIES * 2 * sizeof(uint64_t)] __attribute__((aligned(PAGE_SIZE)));
+    shadow->fctl = read32((uintptr_t)&rv_iommu_regs()->fctl);
+    shadow->icvec = read64((uintptr_t)&rv_iommu_regs()->icvec);
+    shadow->iocntinh = read32((uintptr_t)&rv_iommu_regs()->iocntinh);
 
-// N_entries * 32 bytes
-uint64_t fault_queue[FQ_N_ENTRIES * 4 * sizeof(uint64_t)] __attribute__((aligned(PAGE_SIZE)));
+    for (size_t i = 0; i < IOMMU_MAX_HPM_COUNTERS; i++)
+        shadow->iohpmevt[i] = read64((uintptr_t)&rv_iommu_regs()->iohpmevt[i]);
 
-// DDT
-ddt_t root_ddt[DDT_N_ENTRIES] __attribute__((aligned(PAGE_SIZE)));
+    shadow->tr_req_ctl = read64((uintptr_t)&rv_iommu_regs()->debug_inf.tr_req_ctl) & ~TR_REQ_CTL_GO_BIT;
+
+    for (size_t i = 0; i < IOMMU_MAX_MSI_CFG_TABLE; i++)
+    {
+        shadow->msi_cfg_tbl[i].addr = read64((uintptr_t)&rv_iommu_regs()->msi_cfg_tbl[i].addr);
+        shadow->msi_cfg_tbl[i].data = read32((uintptr_t)&rv_iommu_regs()->msi_cfg_tbl[i].data);
+        shadow->msi_cfg_tbl[i].vctl = read32((uintptr_t)&rv_iommu_regs()->msi_cfg_tbl[i].vctl);
+    }
+}
+
+// N_entries * 16 bytes, per instance
+uint64_t command_queue[PLAT_N_IOMMU][CQ_N_ENTRIES * 2 * sizeof(uint64_t)] __attribute__((aligned(PAGE_SIZE)));
+
+// N_entries * 32 bytes, per instance
+uint64_t fault_queue[PLAT_N_IOMMU][FQ_N_ENTRIES * 4 * sizeof(uint64_t)] __attribute__((aligned(PAGE_SIZE)));
 
 // First and second-stage page tables (Already configured)
 extern pte_t s1pt[][512];
 extern pte_t s2pt_root[];
+extern pte_t s1pt_tenant_root[][512];
+extern pte_t s2pt_tenant_root[][2048];
 // MSI page tables (Configured in msi_pts.c)
 extern uint64_t msi_pt[];
 
@@ -87,93 +149,225 @@ extern uint64_t msi_pt[];
 *******************************************************************************************************/
 static inline void rv_iommu_set_msi_cfg_tbl_addr(size_t msi_tlb_entry, uint64_t new_addr)
 {
-    write64((uintptr_t)&iommu->msi_cfg_tbl[msi_tlb_entry].addr, new_addr);
+    rv_iommu_cur()->shadow.msi_cfg_tbl[msi_tlb_entry].addr = new_addr;
+    write64((uintptr_t)&rv_iommu_regs()->msi_cfg_tbl[msi_tlb_entry].addr, new_addr);
 }
 
 uint64_t rv_iommu_get_msi_cfg_tbl_addr(size_t msi_tlb_entry)
 {
-    read64((uintptr_t)&iommu->msi_cfg_tbl[msi_tlb_entry].addr);
+    return rv_iommu_cur()->shadow.msi_cfg_tbl[msi_tlb_entry].addr;
 }
 
 static inline void rv_iommu_set_msi_cfg_tbl_data(size_t msi_tlb_entry, uint32_t new_data)
 {
-    write32((uintptr_t)&iommu->msi_cfg_tbl[msi_tlb_entry].data, new_data);
+    rv_iommu_cur()->shadow.msi_cfg_tbl[msi_tlb_entry].data = new_data;
+    write32((uintptr_t)&rv_iommu_regs()->msi_cfg_tbl[msi_tlb_entry].data, new_data);
 }
 
 void rv_iommu_set_msi_cfg_tbl_vctl(size_t msi_tlb_entry, uint32_t new_vctl)
 {
-    write32((uintptr_t)&iommu->msi_cfg_tbl[msi_tlb_entry].vctl, new_vctl);
+    rv_iommu_cur()->shadow.msi_cfg_tbl[msi_tlb_entry].vctl = new_vctl;
+    write32((uintptr_t)&rv_iommu_regs()->msi_cfg_tbl[msi_tlb_entry].vctl, new_vctl);
 }
 
 /*******************************************************************************************************
 *                                   Command-Queue Related Functions                                    *
 *******************************************************************************************************/
 
-static void rv_iommu_ddt_init(void)
+/**
+ *  In multi-tenant mode, each device is tagged with the GSCID/PSCID of its tenant and
+ *  uses the tenant's root tables. Otherwise, all devices share the same address space.
+ */
+static bool multi_tenant = false;
+
+/**
+ *  Forget the configuration applied by rv_iommu_fixture() (struct rv_iommu.fixture).
+ *  Writes to the ddtp only affect the selected instance, while DC writes affect all of them
+ */
+static inline void rv_iommu_fixture_reset(void)
 {
-    // Init all entries to zero
-    for (int i = 0; i < DDT_N_ENTRIES; i++)
-    {
-        root_ddt[i].tc = 0;
-    }
+    rv_iommu_cur()->fixture = FX_NONE;
+}
 
-    // Configure DCs in the root DDT (1LVL mode)
-    for (int i = DID_MIN; i < DID_MAX + 1; i++)
-    {
-        root_ddt[i].tc = test_dc_tc_table[BASIC];
-        root_ddt[i].iohgatp = (((uintptr_t)s2pt_root) >> 12) | (IOHGATP_MODE_BARE);
-        root_ddt[i].iohgatp |= (GSCID_ARRAY[i] << GSCID_OFF);
-        root_ddt[i].ta = (PSCID_ARRAY[i] << PSCID_OFF);
-        root_ddt[i].fsc = (((uintptr_t)s1pt) >> 12) | (IOSATP_MODE_BARE);
+static inline void rv_iommu_fixture_reset_all(void)
+{
+    for (size_t i = 0; i < PLAT_N_IOMMU; i++)
+        rv_iommu_inst[i].fixture = FX_NONE;
+}
 
-        if (MSI_TRANSLATION == 1)
-        {
-            root_ddt[i].msiptp = (((uintptr_t)msi_pt) >> 12) | (MSIPTP_MODE_OFF);
-            root_ddt[i].msi_addr_mask = MSI_ADDR_MASK;
-            root_ddt[i].msi_addr_pattern = MSI_ADDR_PATTERN;
-            root_ddt[i].reserved = 0;
-        }
-    }
+static inline uint64_t rv_iommu_dc_gscid(int did)
+{
+    return (multi_tenant) ? (TENANT_GSCID_ARRAY[did]) : (GSCID_ARRAY[did]);
+}
+
+static inline uint64_t rv_iommu_dc_pscid(int did)
+{
+    return (multi_tenant) ? (TENANT_PSCID_ARRAY[did]) : (PSCID_ARRAY[did]);
+}
+
+static inline uintptr_t rv_iommu_dc_s1pt_root(int did)
+{
+    return (multi_tenant) ? ((uintptr_t)s1pt_tenant_root[TENANT_OF(did)]) : ((uintptr_t)s1pt);
+}
+
+static inline uintptr_t rv_iommu_dc_s2pt_root(int did)
+{
+    return (multi_tenant) ? ((uintptr_t)s2pt_tenant_root[TENANT_OF(did)]) : ((uintptr_t)s2pt_root);
 }
 
+#if (STATIC_TABLES == 0)
+static void rv_iommu_ddt_init(void)
+{
+    rv_iommu_fixture_reset_all();
+    ddt_init();
+}
+#endif
+
 void rv_iommu_set_iosatp_bare(void)
 {
+    rv_iommu_fixture_reset_all();
+
     for (int i = DID_MIN; i < DID_MAX + 1; i++)
     {
-        root_ddt[i].ta = (PSCID_ARRAY[i] << PSCID_OFF);
-        root_ddt[i].fsc = (((uintptr_t)s1pt) >> 12) | (IOSATP_MODE_BARE);
+        root_ddt[i].ta = (rv_iommu_dc_pscid(i) << PSCID_OFF);
+        root_ddt[i].fsc = (rv_iommu_dc_s1pt_root(i) >> 12) | (IOSATP_MODE_BARE);
     }
 }
 
 void rv_iommu_set_iosatp_sv39()
 {
+    rv_iommu_fixture_reset_all();
+
     for (int i = DID_MIN; i < DID_MAX + 1; i++)
     {
-        root_ddt[i].ta = (PSCID_ARRAY[i] << PSCID_OFF);
-        root_ddt[i].fsc = (((uintptr_t)s1pt) >> 12) | (IOSATP_MODE_SV39);
+        root_ddt[i].ta = (rv_iommu_dc_pscid(i) << PSCID_OFF);
+        root_ddt[i].fsc = (rv_iommu_dc_s1pt_root(i) >> 12) | (IOSATP_MODE_SV39);
     }
 }
 
 void rv_iommu_set_iohgatp_bare()
 {
+    rv_iommu_fixture_reset_all();
+
     for (int i = DID_MIN; i < DID_MAX + 1; i++)
     {
-        root_ddt[i].iohgatp = (((uintptr_t)s2pt_root) >> 12) | (IOHGATP_MODE_BARE);
-        root_ddt[i].iohgatp |= (GSCID_ARRAY[i] << GSCID_OFF);
+        root_ddt[i].iohgatp = (rv_iommu_dc_s2pt_root(i) >> 12) | (IOHGATP_MODE_BARE);
+        root_ddt[i].iohgatp |= (rv_iommu_dc_gscid(i) << GSCID_OFF);
     }
 }
 
 void rv_iommu_set_iohgatp_sv39x4()
 {
+    rv_iommu_fixture_reset_all();
+
+    for (int i = DID_MIN; i < DID_MAX + 1; i++)
+    {
+        root_ddt[i].iohgatp = (rv_iommu_dc_s2pt_root(i) >> 12) | (IOHGATP_MODE_SV39X4);
+        root_ddt[i].iohgatp |= (rv_iommu_dc_gscid(i) << GSCID_OFF);
+    }
+}
+
+/**
+ *  Enable/disable multi-tenant mode.
+ *  Retags all DCs with the GSCID/PSCID and root tables of the corresponding tenant,
+ *  keeping the current translation modes. The DDTC must be invalidated afterwards.
+ */
+void rv_iommu_set_multi_tenant(bool enable)
+{
+    if (enable)
+        tenant_pt_init();
+
+    multi_tenant = enable;
+    rv_iommu_fixture_reset_all();
+
     for (int i = DID_MIN; i < DID_MAX + 1; i++)
     {
-        root_ddt[i].iohgatp = (((uintptr_t)s2pt_root) >> 12) | (IOHGATP_MODE_SV39X4);
-        root_ddt[i].iohgatp |= (GSCID_ARRAY[i] << GSCID_OFF);
+        root_ddt[i].iohgatp = (root_ddt[i].iohgatp & IOHGATP_MODE_MASK) |
+                                (rv_iommu_dc_s2pt_root(i) >> 12) | (rv_iommu_dc_gscid(i) << GSCID_OFF);
+        root_ddt[i].ta = (rv_iommu_dc_pscid(i) << PSCID_OFF);
+        root_ddt[i].fsc = (root_ddt[i].fsc & IOSATP_MODE_MASK) | (rv_iommu_dc_s1pt_root(i) >> 12);
+    }
+
+    fence_i();
+}
+
+/**
+ *  Apply one of the common IOMMU configurations (ddtp mode, DC translation and MSI modes).
+ *  The DCs are not rewritten if the configuration is still applied, which only holds within
+ *  a test: rv_iommu_restore() brings the DDT back to its post-init state.
+ *  Returns true if the DCs were rewritten, i.e., the DDTC and IOTLB may hold stale entries
+ */
+bool rv_iommu_fixture(enum iommu_fixture fx)
+{
+    if (fx == rv_iommu_cur()->fixture)
+        return false;
+
+    fence_i();
+
+    switch (fx)
+    {
+        case FX_OFF:
+            set_iommu_off();
+            break;
+        case FX_BARE:
+            set_iommu_bare();
+            break;
+        case FX_STAGES_BARE:
+            set_iommu_1lvl();
+            rv_iommu_set_iosatp_bare();
+            rv_iommu_set_iohgatp_bare();
+            rv_iommu_set_msi_off();
+            break;
+        case FX_S1_ONLY:
+            set_iommu_1lvl();
+            rv_iommu_set_iosatp_sv39();
+            rv_iommu_set_iohgatp_bare();
+            rv_iommu_set_msi_off();
+            break;
+        case FX_S2_ONLY:
+        case FX_S2_ONLY_MSI:
+            set_iommu_1lvl();
+            rv_iommu_set_iosatp_bare();
+            rv_iommu_set_iohgatp_sv39x4();
+            if (fx == FX_S2_ONLY_MSI)
+                rv_iommu_set_msi_flat();
+            else
+                rv_iommu_set_msi_off();
+            break;
+        case FX_TWO_STAGE:
+        case FX_TWO_STAGE_MSI:
+            set_iommu_1lvl();
+            rv_iommu_set_iosatp_sv39();
+            rv_iommu_set_iohgatp_sv39x4();
+            if (fx == FX_TWO_STAGE_MSI)
+                rv_iommu_set_msi_flat();
+            else
+                rv_iommu_set_msi_off();
+            break;
+        default:
+            return true;
     }
+
+    fence_i();
+    rv_iommu_cur()->fixture = fx;
+
+    return true;
+}
+
+uint64_t rv_iommu_get_dc_gscid(uint64_t device_id)
+{
+    return rv_iommu_dc_gscid(device_id);
+}
+
+uint64_t rv_iommu_get_dc_pscid(uint64_t device_id)
+{
+    return rv_iommu_dc_pscid(device_id);
 }
 
 void rv_iommu_set_msi_off()
 {
+    rv_iommu_fixture_reset_all();
+
     if (MSI_TRANSLATION == 1)
     {
         for (int i = DID_MIN; i < DID_MAX + 1; i++)
@@ -187,6 +381,8 @@ void rv_iommu_set_msi_off()
 
 void rv_iommu_set_msi_flat()
 {
+    rv_iommu_fixture_reset_all();
+
     if (MSI_TRANSLATION == 1)
     {
         for (int i = DID_MIN; i < DID_MAX + 1; i++)
@@ -206,47 +402,56 @@ void rv_iommu_set_msi_flat()
 *******************************************************************************************************/
 static inline void rv_iommu_write_command_in_queue(command_t new_cmd)
 {
-    uint32_t cqt = read32((uintptr_t)&iommu->cqt);
+    struct rv_iommu *inst = rv_iommu_cur();
+    uint32_t cqt = inst->cqt;
+
+    // Wait for a free entry if the queue is full
+    WAIT_UNTIL(((cqt + 1) & (CQ_N_ENTRIES - 1)) != read32((uintptr_t)&rv_iommu_regs()->cqh), WAIT_BUDGET, "CQ entry free");
+
     // Get address of the next entry to write in the CQ
-    uintptr_t cq_entry_base = ((uintptr_t)command_queue & CQ_PPN_MASK) | (cqt << 4);
+    uintptr_t cq_entry_base = ((uintptr_t)inst->cq & CQ_PPN_MASK) | (cqt << 4);
 
     // Write command to memory
     write64(cq_entry_base, new_cmd[0]);
     write64(cq_entry_base + 8, new_cmd[1]);
 
-    // increment the command-queue tail index
-    cqt++;
-    write32((uintptr_t)&iommu->cqt, cqt);
+    // increment the command-queue tail index (wraps around the queue size)
+    cqt = (cqt + 1) & (CQ_N_ENTRIES - 1);
+    inst->cqt = cqt;
+    write32((uintptr_t)&rv_iommu_regs()->cqt, cqt);
 }
 
 void rv_iommu_cq_init(void)
 {
+    struct rv_iommu *inst = rv_iommu_cur();
+
     // Configure cqb with base PPN of the queue and size as log2(N)
-    write64((uintptr_t)&iommu->cqb, ((((uintptr_t)command_queue) >> 2) & CQB_PPN_MASK) | CQ_LOG2SZ_1);
+    write64((uintptr_t)&rv_iommu_regs()->cqb, ((((uintptr_t)inst->cq) >> 2) & CQB_PPN_MASK) | CQ_LOG2SZ_1);
 
     // Set cqt equal to cqh
-    write32((uintptr_t)&iommu->cqt, read32((uintptr_t)&iommu->cqh));
+    inst->cqt = read32((uintptr_t)&rv_iommu_regs()->cqh);
+    write32((uintptr_t)&rv_iommu_regs()->cqt, inst->cqt);
 
     // Write 1 to cqcsr.cqen to enable the CQ
-    write32((uintptr_t)&iommu->cqcsr, CQCSR_CQEN | CQCSR_CIE);
+    write32((uintptr_t)&rv_iommu_regs()->cqcsr, CQCSR_CQEN | CQCSR_CIE);
 
     // Poll cqcsr.cqon until it reads 1
-    while (!(read32((uintptr_t)&iommu->cqcsr) & CQCSR_CQON));
+    WAIT_UNTIL(read32((uintptr_t)&rv_iommu_regs()->cqcsr) & CQCSR_CQON, WAIT_BUDGET, "cqcsr.cqon");
 }
 
 uint32_t rv_iommu_get_cqh(void)
 {
-    return read32((uintptr_t)&iommu->cqh);
+    return read32((uintptr_t)&rv_iommu_regs()->cqh);
 }
 
 uint32_t rv_iommu_get_cqcsr(void)
 {
-    return read32((uintptr_t)&iommu->cqcsr);
+    return read32((uintptr_t)&rv_iommu_regs()->cqcsr);
 }
 
 void rv_iommu_set_cqcsr(uint32_t new_cqcsr)
 {
-    write32((uintptr_t)&iommu->cqcsr, new_cqcsr);
+    write32((uintptr_t)&rv_iommu_regs()->cqcsr, new_cqcsr);
 }
 
 void rv_iommu_induce_fault_cq(void)
@@ -267,7 +472,7 @@ void rv_iommu_ddt_inval(bool dv, uint64_t device_id)
 {
     command_t new_cmd;
 
-    INFO("Writing IODIR.INVAL_DDT to CQ")
+    DETAIL("Writing IODIR.INVAL_DDT to CQ")
     new_cmd[0]    = IODIR | INVAL_DDT;
     // Add device_id if needed
     if (dv){
@@ -282,7 +487,7 @@ void rv_iommu_iotinval_vma(bool av, bool gv, bool pscv, uint64_t addr, uint64_t
 {
     command_t new_cmd;
 
-    INFO("Writing IOTINVAL.VMA to CQ")
+    DETAIL("Writing IOTINVAL.VMA to CQ")
     new_cmd[0]    = IOTINVAL | VMA;
 
     // Add GSCID
@@ -306,7 +511,7 @@ void rv_iommu_iotinval_gvma(bool av, bool gv, uint64_t addr, uint64_t gscid)
 {
     command_t new_cmd;
 
-    INFO("Writing IOTINVAL.GVMA to CQ")
+    DETAIL("Writing IOTINVAL.GVMA to CQ")
     new_cmd[0]    = IOTINVAL | GVMA;
 
     // Add GSCID
@@ -326,7 +531,7 @@ void rv_iommu_iofence_c(bool wsi, bool av)
 {
     command_t new_cmd;
 
-    INFO("Writing IOFENCE to CQ")
+    DETAIL("Writing IOFENCE to CQ")
     new_cmd[0]    = IOFENCE | FUNC3_C;
 
     // Add WSI
@@ -344,6 +549,23 @@ void rv_iommu_iofence_c(bool wsi, bool av)
     rv_iommu_write_command_in_queue(new_cmd);
 }
 
+/**
+ *  Issue an IOFENCE.C and wait until the IOMMU has fetched it.
+ *  All commands previously written to the CQ are completed at return
+ */
+void rv_iommu_cq_sync(void)
+{
+    command_t new_cmd;
+
+    new_cmd[0]    = IOFENCE | FUNC3_C;
+    new_cmd[1]    = 0;
+
+    rv_iommu_write_command_in_queue(new_cmd);
+
+    uint32_t cqt = rv_iommu_cur()->cqt;
+    WAIT_UNTIL(read32((uintptr_t)&rv_iommu_regs()->cqh) == cqt, WAIT_BUDGET, "CQ drained (IOFENCE.C)");
+}
+
 uint32_t rv_iommu_get_iofence(void)
 {
     uintptr_t iofence_addr = IOFENCE_ADDR;
@@ -351,36 +573,42 @@ uint32_t rv_iommu_get_iofence(void)
     return iofence_data;
 }
 
+static inline void rv_iommu_set_fqh(uint32_t fqh_new)
+{
+    rv_iommu_cur()->fqh = fqh_new;
+    write32((uintptr_t)&rv_iommu_regs()->fqh, fqh_new);
+}
+
 static void rv_iommu_fq_init(void)
 {
     uint64_t   fqb;
 
     // Configure fqb with base PPN of the queue and size as log2(N)
-    fqb = ((((uintptr_t)fault_queue) >> 2) & FQB_PPN_MASK) | FQ_LOG2SZ_1;
-    write64((uintptr_t)&iommu->fqb, fqb);
+    fqb = ((((uintptr_t)rv_iommu_cur()->fq) >> 2) & FQB_PPN_MASK) | FQ_LOG2SZ_1;
+    write64((uintptr_t)&rv_iommu_regs()->fqb, fqb);
 
-    write32((uintptr_t)&iommu->fqh, read32((uintptr_t)&iommu->fqt));
+    rv_iommu_set_fqh(read32((uintptr_t)&rv_iommu_regs()->fqt));
 
     // Write 1 to fqcsr.fqen to enable the FQ
-    write32((uintptr_t)&iommu->fqcsr, FQCSR_FQEN | FQCSR_FIE);
+    write32((uintptr_t)&rv_iommu_regs()->fqcsr, FQCSR_FQEN | FQCSR_FIE);
 
     // Poll fqcsr.fqon until it reads 1
-    while (!(read32((uintptr_t)&iommu->fqcsr) & FQCSR_FQON));
+    WAIT_UNTIL(read32((uintptr_t)&rv_iommu_regs()->fqcsr) & FQCSR_FQON, WAIT_BUDGET, "fqcsr.fqon");
 }
 /*******************************************************************************************************
 *******************************************************************************************************/
 
 int rv_iommu_fq_read_record(uint64_t *buf)
 {
-    // Read fqh
-    uint32_t fqh = read32((uintptr_t)&iommu->fqh);
+    // fqh is software-owned
+    uint32_t fqh = rv_iommu_cur()->fqh;
 
     // Read fqt
-    uint32_t fqt = read32((uintptr_t)&iommu->fqt);
+    uint32_t fqt = read32((uintptr_t)&rv_iommu_regs()->fqt);
 
     if (fqh != fqt) {
         // Get address of the next entry in the FQ
-        uintptr_t fq_entry_base = ((uintptr_t)fault_queue & FQ_PPN_MASK) | (fqh << 5);
+        uintptr_t fq_entry_base = ((uintptr_t)rv_iommu_cur()->fq & FQ_PPN_MASK) | (fqh << 5);
 
         // Read FQ record by DWs
         buf[0] = read64(fq_entry_base + 0 );
@@ -388,8 +616,8 @@ int rv_iommu_fq_read_record(uint64_t *buf)
         buf[2] = read64(fq_entry_base + 16);
         buf[3] = read64(fq_entry_base + 24);
 
-        fqh++;
-        write32((uintptr_t)&iommu->fqh, fqh);
+        // increment the fault-queue head index (wraps around the queue size)
+        rv_iommu_set_fqh((fqh + 1) & (FQ_N_ENTRIES - 1));
 
         return 0;
     } else {
@@ -402,48 +630,74 @@ int rv_iommu_fq_read_record(uint64_t *buf)
  */
 void set_iommu_off()
 {
+    rv_iommu_fixture_reset();
+
     // Program ddtp register with DDT mode and root DDT base PPN
-    uintptr_t ddtp = ((((uintptr_t)root_ddt) >> 2) & DDTP_PPN_MASK) | (DDTP_MODE_OFF);
+    uintptr_t ddtp = ((((uintptr_t)rv_iommu_cur()->ddt) >> 2) & DDTP_PPN_MASK) | (DDTP_MODE_OFF);
 
-    write64((uintptr_t)&iommu->ddtp, ddtp);
+    write64((uintptr_t)&rv_iommu_regs()->ddtp, ddtp);
 }
 
 void set_iommu_bare()
 {
+    rv_iommu_fixture_reset();
+
     // Program ddtp register with DDT mode and root DDT base PPN
-    uintptr_t ddtp = ((((uintptr_t)root_ddt) >> 2) & DDTP_PPN_MASK) | (DDTP_MODE_BARE);
+    uintptr_t ddtp = ((((uintptr_t)rv_iommu_cur()->ddt) >> 2) & DDTP_PPN_MASK) | (DDTP_MODE_BARE);
 
-    write64((uintptr_t)&iommu->ddtp, ddtp);
+    write64((uintptr_t)&rv_iommu_regs()->ddtp, ddtp);
 }
 
 void set_iommu_1lvl()
 {
+    rv_iommu_fixture_reset();
+
     // Program ddtp register with DDT mode and root DDT base PPN
-    uintptr_t ddtp = ((((uintptr_t)root_ddt) >> 2) & DDTP_PPN_MASK) | (DDTP_MODE_1LVL);
+    uintptr_t ddtp = ((((uintptr_t)rv_iommu_cur()->ddt) >> 2) & DDTP_PPN_MASK) | (DDTP_MODE_1LVL);
     
-    write64((uintptr_t)&iommu->ddtp, ddtp);
+    write64((uintptr_t)&rv_iommu_regs()->ddtp, ddtp);
+}
+
+static inline void rv_iommu_set_fctl(uint32_t fctl_new)
+{
+    rv_iommu_cur()->shadow.fctl = fctl_new;
+    write32((uintptr_t)&rv_iommu_regs()->fctl, fctl_new);
 }
 
 void set_ig_wsi()
 {
     uint32_t fctl = (1UL << 1);
-    write32((uintptr_t)&iommu->fctl, fctl);
+    rv_iommu_set_fctl(fctl);
 }
 
 void set_ig_msi()
 {
     uint32_t fctl = (0UL << 1);
-    write32((uintptr_t)&iommu->fctl, fctl);
+    rv_iommu_set_fctl(fctl);
+}
+
+/**
+ *  Print the state of the IOMMU queues, interrupts and DDT (e.g., upon a wait timeout)
+ */
+void rv_iommu_dump_state(void)
+{
+    printf("IOMMU state (0x%llx):\n", rv_iommu_cur()->base);
+    printf("\tddtp:  0x%016llx\n", read64((uintptr_t)&rv_iommu_regs()->ddtp));
+    printf("\tcqcsr: 0x%08x  cqh: %u  cqt: %u\n", read32((uintptr_t)&rv_iommu_regs()->cqcsr),
+            read32((uintptr_t)&rv_iommu_regs()->cqh), read32((uintptr_t)&rv_iommu_regs()->cqt));
+    printf("\tfqcsr: 0x%08x  fqh: %u  fqt: %u\n", read32((uintptr_t)&rv_iommu_regs()->fqcsr),
+            read32((uintptr_t)&rv_iommu_regs()->fqh), read32((uintptr_t)&rv_iommu_regs()->fqt));
+    printf("\tipsr:  0x%08x  fctl: 0x%08x\n", read32((uintptr_t)&rv_iommu_regs()->ipsr), read32((uintptr_t)&rv_iommu_regs()->fctl));
 }
 
 uint32_t rv_iommu_get_ipsr() 
 {
-    return read32((uintptr_t)&iommu->ipsr);
+    return read32((uintptr_t)&rv_iommu_regs()->ipsr);
 }
 
 void rv_iommu_set_ipsr(uint32_t ipsr_new) 
 {
-    write32((uintptr_t)&iommu->ipsr, ipsr_new);
+    write32((uintptr_t)&rv_iommu_regs()->ipsr, ipsr_new);
 }
 
 void rv_iommu_clear_ipsr_fip()
@@ -453,137 +707,182 @@ void rv_iommu_clear_ipsr_fip()
 
 uint32_t rv_iommu_get_iocountovf()
 {
-    return read32((uintptr_t)&iommu->iocntovf);
+    return read32((uintptr_t)&rv_iommu_regs()->iocntovf);
 }
 
 uint32_t rv_iommu_get_iocountihn()
 {
-    return read32((uintptr_t)&iommu->iocntinh);
+    return rv_iommu_cur()->shadow.iocntinh;
 }
 
 void rv_iommu_set_iocountihn(uint32_t iocountihn_new)
 {
-    return write32((uintptr_t)&iommu->iocntinh, iocountihn_new);
+    rv_iommu_cur()->shadow.iocntinh = iocountihn_new;
+    write32((uintptr_t)&rv_iommu_regs()->iocntinh, iocountihn_new);
 }
 
 uint64_t rv_iommu_get_iohpmcycles()
 {
-    return read64((uintptr_t)&iommu->iohpmcycles);
+    return read64((uintptr_t)&rv_iommu_regs()->iohpmcycles);
 }
 
 void rv_iommu_set_iohpmcycles(uint64_t iohpmcycles_new)
 {
-    return write64((uintptr_t)&iommu->iohpmcycles, iohpmcycles_new);
+    return write64((uintptr_t)&rv_iommu_regs()->iohpmcycles, iohpmcycles_new);
 }
 
 uint64_t rv_iommu_get_iohpmctr (size_t counter_idx)
 {
-    return read64((uintptr_t)&iommu->iohpmctr[counter_idx]);
+    return read64((uintptr_t)&rv_iommu_regs()->iohpmctr[counter_idx]);
 }
 
 void rv_iommu_set_iohpmctr(uint64_t iohpmctr_new, size_t counter_idx)
 {
-    return write64((uintptr_t)&iommu->iohpmctr[counter_idx], iohpmctr_new);
+    return write64((uintptr_t)&rv_iommu_regs()->iohpmctr[counter_idx], iohpmctr_new);
 }
 
+// Reads the register, since hardware sets iohpmevt.OF upon overflow
 uint64_t rv_iommu_get_iohpmevt (size_t counter_idx)
 {
-    return read64((uintptr_t)&iommu->iohpmevt[counter_idx]);
+    rv_iommu_cur()->shadow.iohpmevt[counter_idx] = read64((uintptr_t)&rv_iommu_regs()->iohpmevt[counter_idx]);
+    return rv_iommu_cur()->shadow.iohpmevt[counter_idx];
 }
 
 void rv_iommu_set_iohpmevt(uint64_t iohpmevt_new, size_t counter_idx)
 {
-    return write64((uintptr_t)&iommu->iohpmevt[counter_idx], iohpmevt_new);
+    rv_iommu_cur()->shadow.iohpmevt[counter_idx] = iohpmevt_new;
+    write64((uintptr_t)&rv_iommu_regs()->iohpmevt[counter_idx], iohpmevt_new);
 }
 
 void rv_iommu_set_icvec(uint64_t icvec_new)
 {
-    return write64((uintptr_t)&iommu->icvec, icvec_new);
+    rv_iommu_cur()->shadow.icvec = icvec_new;
+    write64((uintptr_t)&rv_iommu_regs()->icvec, icvec_new);
 }
 
 void rv_iommu_dbg_set_iova(uint64_t iova)
 {
-    write64((uintptr_t)&iommu->debug_inf.tr_req_iova, (iova & ~0xFFFULL));
+    write64((uintptr_t)&rv_iommu_regs()->debug_inf.tr_req_iova, (iova & ~0xFFFULL));
 }
 
 static inline uint64_t rv_iommu_dbg_get_ctl()
 {
-    return read64((uintptr_t)&iommu->debug_inf.tr_req_ctl);
+    return read64((uintptr_t)&rv_iommu_regs()->debug_inf.tr_req_ctl);
+}
+
+// Write the request fields held in the shadow (GO clear)
+static inline void rv_iommu_dbg_set_ctl(uint64_t ctl_new)
+{
+    rv_iommu_cur()->shadow.tr_req_ctl = ctl_new;
+    write64((uintptr_t)&rv_iommu_regs()->debug_inf.tr_req_ctl, ctl_new);
 }
 
 static inline uint64_t rv_iommu_dbg_get_response()
 {
-    return read64((uintptr_t)&iommu->debug_inf.tr_response);
+    return read64((uintptr_t)&rv_iommu_regs()->debug_inf.tr_response);
 }
 
 void rv_iommu_dbg_set_did(uint64_t device_id)
 {
-    uint64_t ctl_tmp = rv_iommu_dbg_get_ctl();
+    uint64_t ctl_tmp = rv_iommu_cur()->shadow.tr_req_ctl;
+    ctl_tmp &= (~TR_REQ_CTL_DID_MASK);
     ctl_tmp |= ((device_id << TR_REQ_CTL_DID_OFFSET) & TR_REQ_CTL_DID_MASK);
 
-    write64((uintptr_t)&iommu->debug_inf.tr_req_ctl, ctl_tmp);
+    rv_iommu_dbg_set_ctl(ctl_tmp);
 };
 
 void rv_iommu_dbg_set_pv(bool pv)
 {
-    uint64_t ctl_tmp = rv_iommu_dbg_get_ctl();
+    uint64_t ctl_tmp = rv_iommu_cur()->shadow.tr_req_ctl;
     if (pv){
         ctl_tmp |= TR_REQ_CTL_PV_BIT;
     } else {
         ctl_tmp &= (~TR_REQ_CTL_PV_BIT);
     }
 
-    write64((uintptr_t)&iommu->debug_inf.tr_req_ctl, ctl_tmp);
+    rv_iommu_dbg_set_ctl(ctl_tmp);
 };
 
 void rv_iommu_dbg_set_priv(bool priv)
 {
-    uint64_t ctl_tmp = rv_iommu_dbg_get_ctl();
+    uint64_t ctl_tmp = rv_iommu_cur()->shadow.tr_req_ctl;
     if (priv){
         ctl_tmp |= TR_REQ_CTL_PRIV_BIT;
     } else {
         ctl_tmp &= (~TR_REQ_CTL_PRIV_BIT);
     }
 
-    write64((uintptr_t)&iommu->debug_inf.tr_req_ctl, ctl_tmp);
+    rv_iommu_dbg_set_ctl(ctl_tmp);
 };
 
 void rv_iommu_dbg_set_rw(bool rw)
 {
-    uint64_t ctl_tmp = rv_iommu_dbg_get_ctl();
+    uint64_t ctl_tmp = rv_iommu_cur()->shadow.tr_req_ctl;
     if (rw){
         ctl_tmp &= (~TR_REQ_CTL_NW_BIT);
     } else {
         ctl_tmp |= TR_REQ_CTL_NW_BIT;
     }
 
-    write64((uintptr_t)&iommu->debug_inf.tr_req_ctl, ctl_tmp);
+    rv_iommu_dbg_set_ctl(ctl_tmp);
 };
 
 void rv_iommu_dbg_set_exe(bool exe)
 {
-    uint64_t ctl_tmp = rv_iommu_dbg_get_ctl();
+    uint64_t ctl_tmp = rv_iommu_cur()->shadow.tr_req_ctl;
     if (exe){
         ctl_tmp |= TR_REQ_CTL_EXE_BIT;
     } else {
         ctl_tmp &= (~TR_REQ_CTL_EXE_BIT);
     }
 
-    write64((uintptr_t)&iommu->debug_inf.tr_req_ctl, ctl_tmp);
+    rv_iommu_dbg_set_ctl(ctl_tmp);
 };
 
 void rv_iommu_dbg_set_go(void)
 {
-    uint64_t ctl_tmp = rv_iommu_dbg_get_ctl();
-    ctl_tmp |= TR_REQ_CTL_GO_BIT;
-    write64((uintptr_t)&iommu->debug_inf.tr_req_ctl, ctl_tmp);
+    write64((uintptr_t)&rv_iommu_regs()->debug_inf.tr_req_ctl, rv_iommu_cur()->shadow.tr_req_ctl | TR_REQ_CTL_GO_BIT);
 }
 
 bool rv_iommu_dbg_req_is_complete(void)
 {
     uint64_t ctl_tmp = rv_iommu_dbg_get_ctl();
     
-    return ((ctl_tmp & TR_REQ_CTL_GO_BIT != 0) ? (false) : (true));
+    return ((ctl_tmp & TR_REQ_CTL_GO_BIT) == 0);
+}
+
+/**
+ *  Translate an IOVA through the debug interface of the selected instance.
+ *  tr_req_ctl is composed from the request and written once with GO set, and the response
+ *  is decoded from a single read of tr_response. Returns true if the translation did not fault
+ */
+bool rv_iommu_dbg_translate(const struct rv_iommu_dbg_req *req, struct rv_iommu_dbg_resp *resp)
+{
+    uint64_t ctl = ((req->device_id << TR_REQ_CTL_DID_OFFSET) & TR_REQ_CTL_DID_MASK) |
+                   ((req->process_id << TR_REQ_CTL_PID_OFFSET) & TR_REQ_CTL_PID_MASK);
+
+    if (req->pv)
+        ctl |= TR_REQ_CTL_PV_BIT;
+    if (req->priv)
+        ctl |= TR_REQ_CTL_PRIV_BIT;
+    if (req->exe)
+        ctl |= TR_REQ_CTL_EXE_BIT;
+    if (!req->rw)
+        ctl |= TR_REQ_CTL_NW_BIT;
+
+    rv_iommu_dbg_set_iova(req->iova);
+
+    rv_iommu_cur()->shadow.tr_req_ctl = ctl;
+    write64((uintptr_t)&rv_iommu_regs()->debug_inf.tr_req_ctl, ctl | TR_REQ_CTL_GO_BIT);
+
+    WAIT_UNTIL(rv_iommu_dbg_req_is_complete(), WAIT_BUDGET, "debug translation completion");
+
+    uint64_t resp_tmp = rv_iommu_dbg_get_response();
+    resp->fault = ((resp_tmp & TR_RESPONSE_FAULT_BIT) != 0);
+    resp->superpage = ((resp_tmp & TR_RESPONSE_SP_BIT) != 0);
+    resp->ppn = ((resp_tmp & TR_RESPONSE_PPN_MASK) >> TR_RESPONSE_PPN_OFFSET);
+
+    return !resp->fault;
 }
 
 uint8_t rv_iommu_dbg_req_fault(void)
@@ -619,6 +918,99 @@ uint8_t rv_iommu_dbg_ppn_encode_x(void)
     return x_idx;
 }
 
+/**
+ *  Set up the handle of an instance and check that the instance is present
+ */
+static void rv_iommu_probe(size_t idx)
+{
+    struct rv_iommu *inst = &rv_iommu_inst[idx];
+
+    inst->base = PLAT_IOMMU_BASE(idx);
+    inst->cq = command_queue[idx];
+    inst->fq = fault_queue[idx];
+    inst->ddt = root_ddt;
+    inst->caps = read64(inst->base + IOMMU_CAPABILITIES_OFFSET);
+
+    if (inst->caps == 0)
+        {ERROR("IOMMU %lu not found at 0x%llx", idx, inst->base)}
+
+    VERBOSE("IOMMU %lu at 0x%llx: capabilities 0x%016llx", idx, inst->base, inst->caps);
+}
+
+/**
+ *  Configure the MSI config table, IGS (WSI) and icvec of the selected instance
+ */
+static void rv_iommu_msi_cfg_init(void)
+{
+    INFO("Configuring IOMMU interrupts: MSI config table");
+    // CQ
+    INFO("Configuring IOMMU CQ interrupt");
+    rv_iommu_set_msi_cfg_tbl_addr(CQ_INT_VECTOR, MSI_ADDR_CQ);
+    rv_iommu_set_msi_cfg_tbl_data(CQ_INT_VECTOR, MSI_DATA_CQ);
+    rv_iommu_set_msi_cfg_tbl_vctl(CQ_INT_VECTOR, MSI_VCTL_CQ);
+
+    // FQ
+    INFO("Configuring IOMMU FQ interrupt");
+    rv_iommu_set_msi_cfg_tbl_addr(FQ_INT_VECTOR, MSI_ADDR_FQ);
+    rv_iommu_set_msi_cfg_tbl_data(FQ_INT_VECTOR, MSI_DATA_FQ);
+    rv_iommu_set_msi_cfg_tbl_vctl(FQ_INT_VECTOR, MSI_VCTL_FQ);
+
+    // HPM
+    INFO("Configuring IOMMU HPM interrupt");
+    rv_iommu_set_msi_cfg_tbl_addr(HPM_INT_VECTOR, MSI_ADDR_HPM);
+    rv_iommu_set_msi_cfg_tbl_data(HPM_INT_VECTOR, MSI_DATA_HPM);
+    rv_iommu_set_msi_cfg_tbl_vctl(HPM_INT_VECTOR, MSI_VCTL_HPM);
+
+    INFO("Configuring IGS to WSI");
+    //# Configure the IOMMU to generate interrupts as WSI by default
+    set_ig_wsi();
+
+    // //# Configure the IOMMU to generate interrupts as MSI
+    // set_ig_msi();
+
+    //# Setup icvec register with an interrupt vector for each cause
+    INFO("Setting up interrupt vectors");
+    uint64_t icvec = (HPM_INT_VECTOR << 8) | (FQ_INT_VECTOR << 4) | (CQ_INT_VECTOR << 0);
+    rv_iommu_set_icvec(icvec);
+}
+
+/**
+ *  Program the HPM event selectors of the selected instance and enable its counters
+ */
+static void rv_iommu_hpm_init(void)
+{
+    INFO("Configuring HPM");
+    // Program event counter registers
+    uint64_t iohpmevt[5];
+    // iohpmevt[0] = HPM_UT_REQ | 
+    //                 ((0xAULL << IOHPMEVT_DID_GSCID_OFF) & (IOHPMEVT_DID_GSCID_MASK)) |
+    //                 (IOHPMEVT_DV_GSCV);
+    // iohpmevt[1] = HPM_IOTLB_MISS | 
+    //                 ((0xBULL << IOHPMEVT_DID_GSCID_OFF) & (IOHPMEVT_DID_GSCID_MASK)) |
+    //                 (IOHPMEVT_DV_GSCV);
+    // iohpmevt[2] = HPM_DDTW | 
+    //                 ((0x0DEFULL << IOHPMEVT_DID_GSCID_OFF) & (IOHPMEVT_DID_GSCID_MASK)) |
+    //                 (IOHPMEVT_DV_GSCV) | (IOHPMEVT_IDT);
+    // iohpmevt[3] = HPM_S2_PTW | 
+    //                 ((0x0AEFULL << IOHPMEVT_DID_GSCID_OFF) & (IOHPMEVT_DID_GSCID_MASK)) |
+    //                 (IOHPMEVT_DV_GSCV) | (IOHPMEVT_IDT) | (IOHPMEVT_DMASK);
+    iohpmevt[0] = HPM_UT_REQ;
+    iohpmevt[1] = HPM_IOTLB_MISS;
+    iohpmevt[2] = HPM_DDTW;
+    iohpmevt[3] = HPM_S1_PTW;
+    iohpmevt[4] = HPM_S2_PTW;
+
+    rv_iommu_set_iohpmevt(iohpmevt[0], 0);
+    rv_iommu_set_iohpmevt(iohpmevt[1], 1);
+    rv_iommu_set_iohpmevt(iohpmevt[2], 2);
+    rv_iommu_set_iohpmevt(iohpmevt[3], 3);
+    rv_iommu_set_iohpmevt(iohpmevt[4], 4);
+
+    // Enable counters by writing to iocountinh
+    uint32_t iocountinh = (uint32_t)(~(CNT_MASK));    // Enable counters
+    rv_iommu_set_iocountihn(iocountinh);
+}
+
 /**
  *  Configure:
  *      - CQ, FQ, S1 and S2 page tables, MSI page tables
@@ -626,15 +1018,27 @@ uint8_t rv_iommu_dbg_ppn_encode_x(void)
  *      - MSI Cfg table
  *      - interrupt vectors for each interrupt source
  *      - Hardware Performance Monitor
+ *  of all IOMMU instances (tables are shared). Instance 0 is selected at return
  */
 void init_iommu()
 {
+    //# Instance handles
+    boot_phase("probe");
+    for (size_t i = 0; i < PLAT_N_IOMMU; i++)
+        rv_iommu_probe(i);
+
+    rv_iommu_select(&rv_iommu_inst[0]);
+
+    // Start from the register values left by reset
+    rv_iommu_shadow_sync();
+
     //# Setup the Command Queue:
     // Allocate a buffer of N (POT) entries (16-bytes each). 
     // This buffer must be alligned to the greater of two values: 4-kiB or N x 16 bytes.
     // Configure cqb with the queue size as log2(N) and the base address of the buffer.
     // Set cqt to zero.
     // Enable the CQ by writing 1 to cqcsr.cqen, poll cqcsr.cqon until it reads 1.
+    boot_phase("cq");
     INFO("Configuring CQ");
     rv_iommu_cq_init();
     VERBOSE("CQ: Interrupts enabled");
@@ -645,10 +1049,12 @@ void init_iommu()
     // Configure fqb with the queue size as log2(N) and the base address of the buffer.
     // Set fqh to zero.
     // Enable the FQ by writing 1 to fqcsr.fqen, poll fqcsr.fqon until it reads 1.
+    boot_phase("fq");
     INFO("Configuring FQ");
     rv_iommu_fq_init();
     VERBOSE("FQ: Interrupts enabled");
 
+#if (STATIC_TABLES == 0)
     //# Configure Page Tables for both translation stages in memory
     // Allocate various buffers to work as multi-level page tables.
     // Fill these buffers with leaf and non-leaf entries (pages and superpages)
@@ -656,12 +1062,14 @@ void init_iommu()
     /**
      * Setup hyp page_tables.
      */
+    boot_phase("s2pt");
     INFO("Configuring second-stage page tables");
     s2pt_init();         // setup iohgatp and second-stage PTEs
 
     /**
      * Setup guest page tables.
      */
+    boot_phase("s1pt");
     INFO("Configuring first-stage page tables");
     s1pt_init();        // setup iosatp and first-stage PTEs
 
@@ -675,6 +1083,7 @@ void init_iommu()
     // Example:     MSI Mask:       ... 0010 0110 1001
     //              MSI Pattern:    ... 00Xa bXXc XdeX
     //              GPPN            ... 00Ya bYYc YdeY
+    boot_phase("msi_pt");
     INFO("Configuring MSI page tables and MRIF");
     msi_pt_init();
     mrif_init();
@@ -694,73 +1103,242 @@ void init_iommu()
     // Save the base address of the first-stage root table in DC.iosatp. Same for second-stage and DC.iohgatp.
     // Define an MSI address mask of 5 bits set for the DC.
     // Define an MSI address pattern for the DC, following the format defined in the mask.
+    boot_phase("ddt");
     INFO("Configuring DDT");
     rv_iommu_ddt_init();
+#else
+    // Tables generated at build time by tools/gen_tables.c and loaded as initialized data
+    boot_phase("static_tables");
+    INFO("Using pre-initialized page tables, MSI page table, MRIF and DDT");
+#endif
     set_iommu_off();
 
     //# Configure MSI Config Table
-    INFO("Configuring IOMMU interrupts: MSI config table");
-    // CQ
-    INFO("Configuring IOMMU CQ interrupt");
-    rv_iommu_set_msi_cfg_tbl_addr(CQ_INT_VECTOR, MSI_ADDR_CQ);
-    rv_iommu_set_msi_cfg_tbl_data(CQ_INT_VECTOR, MSI_DATA_CQ);
-    rv_iommu_set_msi_cfg_tbl_vctl(CQ_INT_VECTOR, MSI_VCTL_CQ);
+    boot_phase("msi_cfg");
+    rv_iommu_msi_cfg_init();
 
-    // FQ
-    INFO("Configuring IOMMU FQ interrupt");
-    rv_iommu_set_msi_cfg_tbl_addr(FQ_INT_VECTOR, MSI_ADDR_FQ);
-    rv_iommu_set_msi_cfg_tbl_data(FQ_INT_VECTOR, MSI_DATA_FQ);
-    rv_iommu_set_msi_cfg_tbl_vctl(FQ_INT_VECTOR, MSI_VCTL_FQ);
+    //# Configure HPM
+    boot_phase("hpm");
+    rv_iommu_hpm_init();
 
-    // HPM
-    INFO("Configuring IOMMU HPM interrupt");
-    rv_iommu_set_msi_cfg_tbl_addr(HPM_INT_VECTOR, MSI_ADDR_HPM);
-    rv_iommu_set_msi_cfg_tbl_data(HPM_INT_VECTOR, MSI_DATA_HPM);
-    rv_iommu_set_msi_cfg_tbl_vctl(HPM_INT_VECTOR, MSI_VCTL_HPM);
+    //# Secondary instances: same queues, interrupts and HPM, IOMMU OFF
+    if (PLAT_N_IOMMU > 1)
+        boot_phase("secondary_iommus");
 
-    INFO("Configuring IGS to WSI");
-    //# Configure the IOMMU to generate interrupts as WSI by default
-    set_ig_wsi();
+    for (size_t i = 1; i < PLAT_N_IOMMU; i++)
+    {
+        INFO("Configuring IOMMU %lu", i);
+        rv_iommu_select(&rv_iommu_inst[i]);
+        rv_iommu_shadow_sync();
+        rv_iommu_cq_init();
+        rv_iommu_fq_init();
+        set_iommu_off();
+        rv_iommu_msi_cfg_init();
+        rv_iommu_hpm_init();
+    }
 
-    // //# Configure the IOMMU to generate interrupts as MSI
-    // set_ig_msi();
+    rv_iommu_select(&rv_iommu_inst[0]);
 
-    //# Setup icvec register with an interrupt vector for each cause
-    INFO("Setting up interrupt vectors");
-    uint64_t icvec = (HPM_INT_VECTOR << 8) | (FQ_INT_VECTOR << 4) | (CQ_INT_VECTOR << 0);
-    rv_iommu_set_icvec(icvec);
+    VERBOSE("IOMMU off | iohgatp: Bare | iosatp: Bare | msiptp: Flat");
+}
 
-    //# Configure HPM
-    INFO("Configuring HPM");
-    // Program event counter registers
-    uint64_t iohpmevt[5];
-    // iohpmevt[0] = HPM_UT_REQ | 
-    //                 ((0xAULL << IOHPMEVT_DID_GSCID_OFF) & (IOHPMEVT_DID_GSCID_MASK)) |
-    //                 (IOHPMEVT_DV_GSCV);
-    // iohpmevt[1] = HPM_IOTLB_MISS | 
-    //                 ((0xBULL << IOHPMEVT_DID_GSCID_OFF) & (IOHPMEVT_DID_GSCID_MASK)) |
-    //                 (IOHPMEVT_DV_GSCV);
-    // iohpmevt[2] = HPM_DDTW | 
-    //                 ((0x0DEFULL << IOHPMEVT_DID_GSCID_OFF) & (IOHPMEVT_DID_GSCID_MASK)) |
-    //                 (IOHPMEVT_DV_GSCV) | (IOHPMEVT_IDT);
-    // iohpmevt[3] = HPM_S2_PTW | 
-    //                 ((0x0AEFULL << IOHPMEVT_DID_GSCID_OFF) & (IOHPMEVT_DID_GSCID_MASK)) |
-    //                 (IOHPMEVT_DV_GSCV) | (IOHPMEVT_IDT) | (IOHPMEVT_DMASK);
-    iohpmevt[0] = HPM_UT_REQ;
-    iohpmevt[1] = HPM_IOTLB_MISS;
-    iohpmevt[2] = HPM_DDTW;
-    iohpmevt[3] = HPM_S1_PTW;
-    iohpmevt[4] = HPM_S2_PTW;
+/*******************************************************************************************************
+*                                   Snapshot/Restore Functions                                         *
+*******************************************************************************************************/
 
-    rv_iommu_set_iohpmevt(iohpmevt[0], 0);
-    rv_iommu_set_iohpmevt(iohpmevt[1], 1);
-    rv_iommu_set_iohpmevt(iohpmevt[2], 2);
-    rv_iommu_set_iohpmevt(iohpmevt[3], 3);
-    rv_iommu_set_iohpmevt(iohpmevt[4], 4);
+/**
+ *  Software-owned structures saved by rv_iommu_snapshot(). DDT changes require a DDTC
+ *  invalidation, and page table changes an IOTLB invalidation, when restored
+ */
+static const struct {
+    void *base;
+    size_t size;
+    bool is_ddt;
+} snap_regions[] = {
+    {root_ddt,  sizeof(ddt_t) * DDT_N_ENTRIES,                  true},
+    {s1pt,      PAGE_SIZE * S1PT_N_TABLES,                      false},
+    {s2pt_root, PAGE_SIZE * 4,                                  false},
+    {s2pt,      PAGE_SIZE * S2PT_N_TABLES,                      false},
+    {msi_pt,    sizeof(uint64_t) * MSI_N_ENTRIES * 2,           false},
+    {mrif,      sizeof(uint64_t) * MRIF_N_DWORDS,               false},
+};
+#define SNAP_N_REGIONS  (sizeof(snap_regions)/sizeof(snap_regions[0]))
+#define SNAP_N_WORDS    ((sizeof(ddt_t) * DDT_N_ENTRIES + PAGE_SIZE * (S1PT_N_TABLES + 4 + S2PT_N_TABLES) +\
+                            sizeof(uint64_t) * (MSI_N_ENTRIES * 2 + MRIF_N_DWORDS)) / sizeof(uint64_t))
+
+// Programmable registers of an instance
+struct snap_inst {
+    uint64_t ddtp;
+    struct iommu_shadow regs;
+    enum iommu_fixture fixture;
+};
 
-    // Enable counters by writing to iocountinh
-    uint32_t iocountinh = (uint32_t)(~(CNT_MASK));    // Enable counters
-    rv_iommu_set_iocountihn(iocountinh);
+static struct {
+    uint64_t mem[SNAP_N_WORDS];
+    struct snap_inst inst[PLAT_N_IOMMU];
+    bool multi_tenant;
+    bool valid;
+} snap;
 
-    VERBOSE("IOMMU off | iohgatp: Bare | iosatp: Bare | msiptp: Flat");
-}
\ No newline at end of file
+/**
+ *  Save the software-owned IOMMU structures (DDT, page tables, MSI PT and MRIF)
+ *  and the programmable registers of all instances. Called once after init_iommu()
+ */
+void rv_iommu_snapshot(void)
+{
+    struct rv_iommu *sel = rv_iommu_selected();
+    uint64_t *dst = snap.mem;
+
+    for (size_t r = 0; r < SNAP_N_REGIONS; r++)
+    {
+        memcpy(dst, snap_regions[r].base, snap_regions[r].size);
+        dst += snap_regions[r].size / sizeof(uint64_t);
+    }
+
+    // Registers as legalized by the IOMMU
+    for (size_t i = 0; i < PLAT_N_IOMMU; i++)
+    {
+        rv_iommu_select(&rv_iommu_inst[i]);
+        rv_iommu_shadow_sync();
+        snap.inst[i].ddtp = read64((uintptr_t)&rv_iommu_regs()->ddtp);
+        snap.inst[i].regs = rv_iommu_inst[i].shadow;
+        snap.inst[i].fixture = rv_iommu_inst[i].fixture;
+    }
+    rv_iommu_select(sel);
+
+    snap.multi_tenant = multi_tenant;
+    snap.valid = true;
+}
+
+/**
+ *  Restore the programmable registers of the selected instance, and invalidate its
+ *  DDTC/IOTLB if the shared DDT or page tables changed
+ */
+static void rv_iommu_restore_inst(const struct snap_inst *saved, bool ddt_changed, bool pt_changed)
+{
+    struct iommu_shadow *shadow = &rv_iommu_cur()->shadow;
+
+    // The DDT (restored by the caller) and ddtp are back to their post-init values
+    rv_iommu_cur()->fixture = saved->fixture;
+
+    //# Programmable registers
+    if (read64((uintptr_t)&rv_iommu_regs()->ddtp) != saved->ddtp)
+    {
+        write64((uintptr_t)&rv_iommu_regs()->ddtp, saved->ddtp);
+        ddt_changed = true;
+    }
+
+    // Registers are compared against the shadow, no MMIO reads needed
+    if (shadow->fctl != saved->regs.fctl)
+        rv_iommu_set_fctl(saved->regs.fctl);
+
+    if (shadow->icvec != saved->regs.icvec)
+        rv_iommu_set_icvec(saved->regs.icvec);
+
+    for (size_t i = 0; i < IOMMU_MAX_MSI_CFG_TABLE; i++)
+    {
+        if (shadow->msi_cfg_tbl[i].addr != saved->regs.msi_cfg_tbl[i].addr)
+            rv_iommu_set_msi_cfg_tbl_addr(i, saved->regs.msi_cfg_tbl[i].addr);
+        if (shadow->msi_cfg_tbl[i].data != saved->regs.msi_cfg_tbl[i].data)
+            rv_iommu_set_msi_cfg_tbl_data(i, saved->regs.msi_cfg_tbl[i].data);
+        if (shadow->msi_cfg_tbl[i].vctl != saved->regs.msi_cfg_tbl[i].vctl)
+            rv_iommu_set_msi_cfg_tbl_vctl(i, saved->regs.msi_cfg_tbl[i].vctl);
+    }
+
+    if (shadow->tr_req_ctl != saved->regs.tr_req_ctl)
+        rv_iommu_dbg_set_ctl(saved->regs.tr_req_ctl);
+
+    //# HPM: inhibit counters while resetting them, then restore event selectors and inhibits.
+    // Selectors of overflowed counters are rewritten to clear iohpmevt.OF
+    rv_iommu_set_iocountihn(~0U);
+    uint32_t iocntovf = rv_iommu_get_iocountovf();
+    rv_iommu_set_iohpmcycles(0);
+    for (size_t i = 0; i < IOMMU_MAX_HPM_COUNTERS; i++)
+    {
+        if (shadow->iohpmevt[i] != saved->regs.iohpmevt[i] || (iocntovf & (1UL << (i + 1))))
+            rv_iommu_set_iohpmevt(saved->regs.iohpmevt[i], i);
+        rv_iommu_set_iohpmctr(0, i);
+    }
+    rv_iommu_set_iocountihn(saved->regs.iocntinh);
+
+    //# Queues: acknowledge errors, discard pending fault records
+    uint32_t cqcsr = read32((uintptr_t)&rv_iommu_regs()->cqcsr);
+    if (cqcsr & (CQCSR_CQMF | CQCSR_CMD_TO | CQCSR_CMD_ILL | CQCSR_FENCE_W_IP))
+        write32((uintptr_t)&rv_iommu_regs()->cqcsr, cqcsr);
+
+    uint32_t fqcsr = read32((uintptr_t)&rv_iommu_regs()->fqcsr);
+    if (fqcsr & (FQCSR_FQMF | FQCSR_FQOF))
+        write32((uintptr_t)&rv_iommu_regs()->fqcsr, fqcsr);
+
+    uint32_t fqt = read32((uintptr_t)&rv_iommu_regs()->fqt);
+    if (rv_iommu_cur()->fqh != fqt)
+        rv_iommu_set_fqh(fqt);
+
+    //# Pending interrupts
+    if (read32((uintptr_t)&rv_iommu_regs()->ipsr))
+        write32((uintptr_t)&rv_iommu_regs()->ipsr, read32((uintptr_t)&rv_iommu_regs()->ipsr));
+
+    //# Caches
+    if (ddt_changed)
+        rv_iommu_ddt_inval(false, 0);
+    if (pt_changed)
+    {
+        rv_iommu_iotinval_vma(false, false, false, 0, 0, 0);
+        rv_iommu_iotinval_gvma(false, false, 0, 0);
+    }
+    if (ddt_changed || pt_changed)
+        rv_iommu_cq_sync();
+}
+
+/**
+ *  Restore the state saved by rv_iommu_snapshot(). Only words and registers that differ
+ *  from the snapshot are written, and the DDTC/IOTLB are only invalidated if the DDT or
+ *  the page tables changed. Pending faults and interrupts are cleared, HPM counters are
+ *  reset, and queue errors are acknowledged. All instances are restored, and the calling
+ *  hart keeps its instance selection. Returns the number of restored memory words
+ */
+size_t rv_iommu_restore(void)
+{
+    if (!snap.valid)
+        return 0;
+
+    struct rv_iommu *sel = rv_iommu_selected();
+    size_t n_restored = 0;
+    bool ddt_changed = false;
+    bool pt_changed = false;
+    uint64_t *src = snap.mem;
+
+    //# Software-owned structures (shared by all instances)
+    for (size_t r = 0; r < SNAP_N_REGIONS; r++)
+    {
+        uint64_t *dst = snap_regions[r].base;
+        size_t n_words = snap_regions[r].size / sizeof(uint64_t);
+
+        for (size_t i = 0; i < n_words; i++)
+        {
+            if (dst[i] != src[i])
+            {
+                dst[i] = src[i];
+                n_restored++;
+                ddt_changed = ddt_changed || snap_regions[r].is_ddt;
+                pt_changed = pt_changed || !snap_regions[r].is_ddt;
+            }
+        }
+
+        src += n_words;
+    }
+
+    multi_tenant = snap.multi_tenant;
+    fence_i();
+
+    //# Instances
+    for (size_t i = 0; i < PLAT_N_IOMMU; i++)
+    {
+        rv_iommu_select(&rv_iommu_inst[i]);
+        rv_iommu_restore_inst(&snap.inst[i], ddt_changed, pt_changed);
+    }
+    rv_iommu_select(sel);
+
+
+    return n_restored;
+}
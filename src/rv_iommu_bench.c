@@ -0,0 +1,1900 @@
+#include <rv_iommu_tests.h>
+#include <page_tables.h>
+#include <rv_iommu.h>
+#include <plat_dma.h>
+#include <idma.h>
+#include <bench.h>
+#include <workload.h>
+#include <wait.h>
+#include <hart.h>
+
+/**
+ * !NOTES:
+ *
+ *  -   Benchmarks are registered in test_register.c like any other test.
+ *      Results are reported with BENCH_REPORT, outside of the timed regions.
+ *
+ *  -   Timestamps are taken with the CPU cycle counter (CSR_CYCLES).
+ *      IOMMU events are obtained from the HPM counters programmed in init_iommu().
+ */
+
+/**
+ *  Translate an IOVA through the debug register interface on behalf of a given device.
+ *  Returns true if the translation completed without faults
+ */
+static bool bench_dbg_translate(uint64_t device_id, uint64_t iova)
+{
+    struct rv_iommu_dbg_req req = {.iova = iova, .device_id = device_id, .rw = true};
+    struct rv_iommu_dbg_resp resp;
+
+    return rv_iommu_dbg_translate(&req, &resp);
+}
+
+/**
+ *  Invalidate all DDTC and IOTLB entries and wait for completion (IOFENCE.C)
+ */
+static void bench_inval_all(void)
+{
+    rv_iommu_ddt_inval(false, 0);
+    rv_iommu_iotinval_vma(false, false, false, 0, 0, 0);
+    rv_iommu_iotinval_gvma(false, false, 0, 0);
+    rv_iommu_cq_sync();
+}
+
+// IOMMU cache states used to precondition a measured transfer
+enum cache_state {
+    CS_COLD,            // DDTC and IOTLB empty
+    CS_IOTLB_COLD,      // DC cached in the DDTC, IOTLB empty
+    CS_WARM,            // DC and translations cached (transfer pre-touched)
+    CS_MAX
+};
+
+static const char* cache_state_strs[] = {
+    [CS_COLD]           = "cold",
+    [CS_IOTLB_COLD]     = "iotlb_cold",
+    [CS_WARM]           = "warm",
+};
+
+/**
+ *  Bring the IOMMU caches to a defined state before a measured transfer.
+ *  The iDMA must be programmed with the transfer to be measured
+ */
+static void bench_precondition(enum cache_state state, struct idma *dma_ut)
+{
+    bench_inval_all();
+
+    if (state == CS_COLD)
+        return;
+
+    //# Pre-touch the transfer to cache the DC and translations
+    if (idma_exec_transfer(dma_ut) != 0)
+        {ERROR("iDMA misconfigured")}
+
+    if (state == CS_IOTLB_COLD)
+    {
+        //# Drop translations, keeping the DC in the DDTC
+        rv_iommu_iotinval_vma(false, false, false, 0, 0, 0);
+        rv_iommu_iotinval_gvma(false, false, 0, 0);
+        rv_iommu_cq_sync();
+    }
+
+    fence_i();
+}
+
+/**********************************************************************************************/
+
+// Number of repetitions of each scoped-invalidation experiment
+#define MT_N_TRIALS     (8)
+
+// Scope of the invalidation issued on behalf of tenant A
+enum mt_scope {
+    MT_SCOPE_GVMA_GSCID,    // IOTINVAL.GVMA with GSCID
+    MT_SCOPE_VMA_PSCID,     // IOTINVAL.VMA with GSCID and PSCID
+    MT_SCOPE_GLOBAL,        // IOTINVAL.VMA + IOTINVAL.GVMA without tags
+    MT_SCOPE_MAX
+};
+
+static const char* mt_scope_strs[] = {
+    [MT_SCOPE_GVMA_GSCID]   = "gvma_gscid",
+    [MT_SCOPE_VMA_PSCID]    = "vma_pscid",
+    [MT_SCOPE_GLOBAL]       = "global",
+};
+
+/**
+ *  Touch the working set of a tenant through the debug interface, using the device ID
+ *  (DID_MIN + idx) as the tenant representative. Accumulates IOTLB misses and cycles
+ */
+static bool mt_touch(size_t idx, uint64_t *misses, uint64_t *cycles)
+{
+    bool ok = true;
+    uint64_t device_id = DID_MIN + idx;
+
+    uint64_t miss_start = rv_iommu_get_iohpmctr(HPM_CTR_IOTLB_MISS);
+    uint64_t stamp_start = CSRR(CSR_CYCLES);
+
+    for (size_t p = 0; p < MT_PAGES_PER_TENANT; p++)
+        ok = bench_dbg_translate(device_id, virt_page_base(STRESS_START + p)) && ok;
+
+    *cycles += CSRR(CSR_CYCLES) - stamp_start;
+    *misses += rv_iommu_get_iohpmctr(HPM_CTR_IOTLB_MISS) - miss_start;
+
+    return ok;
+}
+
+/**
+ *  Invalidate the IOTLB entries of the tenant of device_id with the given scope
+ */
+static void mt_flush(enum mt_scope scope, uint64_t device_id)
+{
+    uint64_t gscid = rv_iommu_get_dc_gscid(device_id);
+    uint64_t pscid = rv_iommu_get_dc_pscid(device_id);
+
+    switch (scope)
+    {
+        case MT_SCOPE_GVMA_GSCID:
+            rv_iommu_iotinval_gvma(false, true, 0, gscid);
+            break;
+        case MT_SCOPE_VMA_PSCID:
+            rv_iommu_iotinval_vma(false, true, true, 0, gscid, pscid);
+            break;
+        default:
+            rv_iommu_iotinval_vma(false, false, false, 0, 0, 0);
+            rv_iommu_iotinval_gvma(false, false, 0, 0);
+            break;
+    }
+
+    rv_iommu_cq_sync();
+}
+
+/**
+ *  Multi-tenant scoped-invalidation cost
+ *
+ *  Devices are tagged with distinct GSCIDs/PSCIDs and use separate root tables (multi-tenant mode).
+ *  Each tenant touches MT_PAGES_PER_TENANT pages through the debug interface to fill the IOTLB.
+ *  Then tenant A (first tenant) is invalidated with different scopes, and all tenants touch their
+ *  working sets again. Extra IOTLB misses w.r.t. a control pass without invalidation are reported.
+ *  Misses taken by tenants B..N are collateral damage of the invalidation.
+ */
+bool tenant_inval_cost(){
+
+    BENCH_START();
+
+    fence_i();
+    set_iommu_1lvl();
+    rv_iommu_set_iosatp_sv39();
+    rv_iommu_set_iohgatp_sv39x4();
+    rv_iommu_set_multi_tenant(true);
+    VERBOSE("IOMMU 1LVL mode | iohgatp: Sv39x4 | iosatp: Sv39 | Multi-tenant");
+
+    //# Start from empty DDTC and IOTLB
+    bench_inval_all();
+
+    bool check_tr = true;
+    bool check_inval = true;
+
+    for (int scope = 0; scope < MT_SCOPE_MAX; scope++)
+    {
+        uint64_t ctrl_miss[N_TENANTS] = {0}, ctrl_cycles[N_TENANTS] = {0};
+        uint64_t post_miss[N_TENANTS] = {0}, post_cycles[N_TENANTS] = {0};
+        uint64_t warm_miss = 0, warm_cycles = 0;
+        uint64_t flush_cycles = 0;
+
+        for (size_t trial = 0; trial < MT_N_TRIALS; trial++)
+        {
+            //# Warm up the IOTLB with the translations of all tenants
+            for (size_t t = 0; t < N_TENANTS; t++)
+                check_tr = mt_touch(t, &warm_miss, &warm_cycles) && check_tr;
+
+            //# Control pass: misses taken without invalidation (capacity and conflicts)
+            for (size_t t = 0; t < N_TENANTS; t++)
+                check_tr = mt_touch(t, &ctrl_miss[t], &ctrl_cycles[t]) && check_tr;
+
+            //# Invalidate tenant A
+            uint64_t stamp_start = CSRR(CSR_CYCLES);
+            mt_flush(scope, DID_MIN);
+            flush_cycles += CSRR(CSR_CYCLES) - stamp_start;
+
+            //# Measure misses taken by all tenants after the invalidation
+            for (size_t t = 0; t < N_TENANTS; t++)
+                check_tr = mt_touch(t, &post_miss[t], &post_cycles[t]) && check_tr;
+        }
+
+        // Tenant A must miss after being invalidated
+        check_inval = check_inval && (post_miss[0] > ctrl_miss[0]);
+
+        BENCH_REPORT("cycles", flush_cycles / MT_N_TRIALS, "%s.flush_latency", mt_scope_strs[scope]);
+
+        uint64_t collateral = 0;
+        for (size_t t = 0; t < N_TENANTS; t++)
+        {
+            uint64_t extra = (post_miss[t] > ctrl_miss[t]) ? (post_miss[t] - ctrl_miss[t]) : (0);
+            if (t != 0)
+                collateral += extra;
+
+            BENCH_REPORT_RATIO("misses", extra, MT_N_TRIALS, "%s.gscid_%03llx.extra_misses",
+                                mt_scope_strs[scope], rv_iommu_get_dc_gscid(DID_MIN + t));
+            BENCH_REPORT("cycles", post_cycles[t] / MT_N_TRIALS, "%s.gscid_%03llx.retouch_cycles",
+                                mt_scope_strs[scope], rv_iommu_get_dc_gscid(DID_MIN + t));
+            BENCH_REPORT("cycles", ctrl_cycles[t] / MT_N_TRIALS, "%s.gscid_%03llx.control_cycles",
+                                mt_scope_strs[scope], rv_iommu_get_dc_gscid(DID_MIN + t));
+        }
+
+        BENCH_REPORT_RATIO("misses", collateral, MT_N_TRIALS, "%s.collateral_misses", mt_scope_strs[scope]);
+    }
+
+    TEST_ASSERT("Multi-tenant: all translations completed without faults", check_tr);
+    TEST_ASSERT("Multi-tenant: invalidated tenant misses in the IOTLB", check_inval);
+
+    //# Back to a single address space
+    rv_iommu_set_multi_tenant(false);
+    bench_inval_all();
+
+    TEST_END();
+}
+
+/**********************************************************************************************/
+
+// Number of transfers issued by each engine per run of the traffic generator
+#define TG_N_XFERS      (64)
+
+// Transfer sizes of the streams, assigned to engines in round-robin
+static const uint64_t tg_xfer_sizes[] = {4096ULL, 1024ULL, 16384ULL, 256ULL};
+#define TG_N_SIZES      (sizeof(tg_xfer_sizes)/sizeof(tg_xfer_sizes[0]))
+
+#if ((BENCH_WINDOW_SIZE / N_DMA / 2) < 16384)
+#   error "Benchmark window too small for the number of DMA engines"
+#endif
+
+// Per-engine stream. Each engine copies from its own source region to its own destination region
+// within the benchmark window, advancing 'size' bytes per transfer
+struct tg_stream {
+    struct idma *dma;
+    uint64_t size;          // Bytes per transfer
+    uint64_t src_off;       // Offset of the source region within the benchmark window
+    uint64_t dst_off;       // Offset of the destination region within the benchmark window
+    uint64_t region_size;   // Size of the source and destination regions
+    uint64_t pos;           // Offset of the next transfer within the regions
+    uint64_t trans_id;      // ID of the in-flight transfer (0 if idle)
+    uint64_t stamp;         // Cycle count when the in-flight transfer was launched
+    size_t issued;
+    uint64_t lat_sum;
+    uint64_t lat_min;
+    uint64_t lat_max;
+};
+
+static struct tg_stream tg_streams[N_DMA];
+
+/**
+ *  Assign a DMA engine, a transfer size and a slice of the benchmark window to each stream.
+ *  Fill source regions with a known pattern and clear destination regions
+ */
+static void tg_init(void)
+{
+    uint64_t slice = BENCH_WINDOW_SIZE / N_DMA;
+
+    for (size_t e = 0; e < N_DMA; e++)
+    {
+        struct tg_stream *s = &tg_streams[e];
+
+        s->dma          = (void*)idma_addr[e];
+        s->size         = tg_xfer_sizes[e % TG_N_SIZES];
+        s->region_size  = (slice / 2) & ~(s->size - 1);
+        s->src_off      = e * slice;
+        s->dst_off      = s->src_off + (slice / 2);
+        s->pos          = 0;
+        s->trans_id     = 0;
+        s->issued       = 0;
+        s->lat_sum      = 0;
+        s->lat_min      = UINT64_MAX;
+        s->lat_max      = 0;
+
+        uint64_t span = s->size * TG_N_XFERS;
+        if (span > s->region_size)
+            span = s->region_size;
+
+        for (uint64_t off = 0; off < span; off += 8)
+        {
+            write64(bench_paddr(s->src_off + off), ((uint64_t)e << 56) | off);
+            write64(bench_paddr(s->dst_off + off), 0);
+        }
+    }
+
+    fence_i();
+}
+
+/**
+ *  Program the next transfer of a stream and launch it
+ */
+static void tg_launch(struct tg_stream *s)
+{
+    if (s->pos + s->size > s->region_size)
+        s->pos = 0;
+
+    idma_setup(s->dma, bench_vaddr(s->src_off + s->pos), bench_vaddr(s->dst_off + s->pos), s->size);
+
+    s->stamp = CSRR(CSR_CYCLES);
+    s->trans_id = idma_submit(s->dma);
+
+    if (!s->trans_id)
+        {ERROR("iDMA misconfigured")}
+
+    s->pos += s->size;
+    s->issued++;
+}
+
+/**
+ *  Check the streams of the first n_engines engines once: record the completed transfers and
+ *  launch the next transfer of their engines. Returns true if any transfer completed
+ */
+static bool tg_step(size_t n_engines, size_t *active)
+{
+    bool progress = false;
+
+    for (size_t e = 0; e < n_engines; e++)
+    {
+        struct tg_stream *s = &tg_streams[e];
+
+        if (!s->trans_id)
+            continue;
+
+        if (!idma_is_complete(s->dma, s->trans_id))
+            continue;
+
+        uint64_t lat = CSRR(CSR_CYCLES) - s->stamp;
+        s->lat_sum += lat;
+        s->lat_min = (lat < s->lat_min) ? (lat) : (s->lat_min);
+        s->lat_max = (lat > s->lat_max) ? (lat) : (s->lat_max);
+        s->trans_id = 0;
+        progress = true;
+
+        if (s->issued < TG_N_XFERS)
+            tg_launch(s);
+        else
+            (*active)--;
+    }
+
+    return progress;
+}
+
+/**
+ *  Keep the first n_engines engines busy until each one completes TG_N_XFERS transfers.
+ *  A new transfer is launched as soon as the previous one of the same engine completes.
+ *  The time between consecutive completions is bounded by WAIT_BUDGET. Returns the elapsed cycles
+ */
+static uint64_t tg_run(size_t n_engines)
+{
+    size_t active = n_engines;
+    uint64_t stamp_start = CSRR(CSR_CYCLES);
+
+    for (size_t e = 0; e < n_engines; e++)
+        tg_launch(&tg_streams[e]);
+
+    while (active)
+        WAIT_UNTIL(tg_step(n_engines, &active), WAIT_BUDGET, "traffic generator transfer completion");
+
+    return (CSRR(CSR_CYCLES) - stamp_start);
+}
+
+/**
+ *  Check that destination regions match source regions for all transfers of a run
+ */
+static bool tg_check(size_t n_engines)
+{
+    fence_i();
+
+    for (size_t e = 0; e < n_engines; e++)
+    {
+        struct tg_stream *s = &tg_streams[e];
+
+        uint64_t span = s->size * TG_N_XFERS;
+        if (span > s->region_size)
+            span = s->region_size;
+
+        for (uint64_t off = 0; off < span; off += 8)
+        {
+            if (read64(bench_paddr(s->dst_off + off)) != read64(bench_paddr(s->src_off + off)))
+                return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+ *  Multi-engine concurrent DMA traffic generator
+ *
+ *  Each iDMA engine runs an independent stream (own device ID, source/destination regions and
+ *  transfer size) through two-stage translation with 4-kiB pages. Runs are repeated with 1..N_DMA
+ *  engines active at once, starting with empty DDTC and IOTLB.
+ *  Reports aggregate throughput, per-engine latency, and IOMMU contention from the HPM counters.
+ */
+bool dma_traffic_scaling(){
+
+    BENCH_START();
+
+    fence_i();
+    set_iommu_1lvl();
+    rv_iommu_set_iosatp_sv39();
+    rv_iommu_set_iohgatp_sv39x4();
+    VERBOSE("IOMMU 1LVL mode | iohgatp: Sv39x4 | iosatp: Sv39");
+
+    bool check = true;
+
+    for (size_t n = 1; n <= N_DMA; n++)
+    {
+        tg_init();
+
+        //# Start from empty DDTC and IOTLB
+        bench_inval_all();
+
+        uint64_t ut_req     = rv_iommu_get_iohpmctr(HPM_CTR_UT_REQ);
+        uint64_t iotlb_miss = rv_iommu_get_iohpmctr(HPM_CTR_IOTLB_MISS);
+        uint64_t ddtw       = rv_iommu_get_iohpmctr(HPM_CTR_DDTW);
+        uint64_t s1_ptw     = rv_iommu_get_iohpmctr(HPM_CTR_S1_PTW);
+        uint64_t s2_ptw     = rv_iommu_get_iohpmctr(HPM_CTR_S2_PTW);
+
+        uint64_t cycles = tg_run(n);
+
+        ut_req      = rv_iommu_get_iohpmctr(HPM_CTR_UT_REQ) - ut_req;
+        iotlb_miss  = rv_iommu_get_iohpmctr(HPM_CTR_IOTLB_MISS) - iotlb_miss;
+        ddtw        = rv_iommu_get_iohpmctr(HPM_CTR_DDTW) - ddtw;
+        s1_ptw      = rv_iommu_get_iohpmctr(HPM_CTR_S1_PTW) - s1_ptw;
+        s2_ptw      = rv_iommu_get_iohpmctr(HPM_CTR_S2_PTW) - s2_ptw;
+
+        check = tg_check(n) && check;
+
+        uint64_t bytes = 0;
+        for (size_t e = 0; e < n; e++)
+            bytes += tg_streams[e].size * TG_N_XFERS;
+
+        BENCH_REPORT_RATIO("B/cycle", bytes, cycles, "engines_%d.throughput", (int)n);
+        BENCH_REPORT("cycles", cycles, "engines_%d.elapsed", (int)n);
+
+        for (size_t e = 0; e < n; e++)
+        {
+            struct tg_stream *s = &tg_streams[e];
+            BENCH_REPORT("bytes", s->size, "engines_%d.dma%d.xfer_size", (int)n, (int)e);
+            BENCH_REPORT("cycles", s->lat_sum / TG_N_XFERS, "engines_%d.dma%d.lat_avg", (int)n, (int)e);
+            BENCH_REPORT("cycles", s->lat_min, "engines_%d.dma%d.lat_min", (int)n, (int)e);
+            BENCH_REPORT("cycles", s->lat_max, "engines_%d.dma%d.lat_max", (int)n, (int)e);
+        }
+
+        BENCH_REPORT("events", ut_req, "engines_%d.ut_req", (int)n);
+        BENCH_REPORT("events", iotlb_miss, "engines_%d.iotlb_miss", (int)n);
+        BENCH_REPORT_RATIO("misses/req", iotlb_miss, ut_req, "engines_%d.iotlb_miss_rate", (int)n);
+        BENCH_REPORT("events", ddtw, "engines_%d.ddt_walks", (int)n);
+        BENCH_REPORT("events", s1_ptw, "engines_%d.s1_ptw", (int)n);
+        BENCH_REPORT("events", s2_ptw, "engines_%d.s2_ptw", (int)n);
+    }
+
+    TEST_ASSERT("DMA traffic generator: all transfers match", check);
+
+    TEST_END();
+}
+
+/**********************************************************************************************/
+
+// Number of transfers per run of the pipelined throughput benchmark
+#define PIPE_N_XFERS    (256)
+
+// Bytes per transfer. Each transfer reads from and writes to a different 4-kiB page
+#define PIPE_XFER_SIZE  (512)
+
+// Offset of the destination pages within the benchmark window
+#define PIPE_DST_OFF    (BENCH_WINDOW_SIZE / 2)
+
+// Maximum number of outstanding transfers
+#define PIPE_MAX_DEPTH  (16)
+
+static const size_t pipe_depths[] = {1, 2, 4, 8, PIPE_MAX_DEPTH};
+#define PIPE_N_DEPTHS   (sizeof(pipe_depths)/sizeof(pipe_depths[0]))
+
+/**
+ *  Fill source pages with a known pattern and clear destination pages
+ */
+static void pipe_init(void)
+{
+    for (size_t i = 0; i < PIPE_N_XFERS; i++)
+    {
+        for (uint64_t off = 0; off < PIPE_XFER_SIZE; off += 8)
+        {
+            write64(bench_paddr(i * PAGE_SIZE + off), (i << 32) | off);
+            write64(bench_paddr(PIPE_DST_OFF + i * PAGE_SIZE + off), 0);
+        }
+    }
+
+    fence_i();
+}
+
+/**
+ *  Check destination pages against source pages
+ */
+static bool pipe_check(void)
+{
+    fence_i();
+
+    for (size_t i = 0; i < PIPE_N_XFERS; i++)
+    {
+        for (uint64_t off = 0; off < PIPE_XFER_SIZE; off += 8)
+        {
+            if (read64(bench_paddr(PIPE_DST_OFF + i * PAGE_SIZE + off)) != ((i << 32) | off))
+                return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+ *  Issue PIPE_N_XFERS transfers keeping up to 'depth' transfers in flight.
+ *  Transfers rejected by the iDMA are retried and counted in 'rejected'.
+ *  Returns the elapsed cycles
+ */
+static uint64_t pipe_run(struct idma *dma_ut, size_t depth, uint64_t *rejected)
+{
+    uint64_t ids[PIPE_MAX_DEPTH];
+    size_t oldest = 0, in_flight = 0;
+    uint64_t trans_id = 0;
+
+    idma_setup(dma_ut, bench_vaddr(0), bench_vaddr(PIPE_DST_OFF), PIPE_XFER_SIZE);
+
+    uint64_t stamp_start = CSRR(CSR_CYCLES);
+
+    for (size_t i = 0; i < PIPE_N_XFERS; i++)
+    {
+        //# Retire the oldest transfer if the pipeline is full
+        if (in_flight == depth)
+        {
+            idma_wait(dma_ut, ids[oldest]);
+            oldest = (oldest + 1) % PIPE_MAX_DEPTH;
+            in_flight--;
+        }
+
+        idma_setup_addr(dma_ut, bench_vaddr(i * PAGE_SIZE), bench_vaddr(PIPE_DST_OFF + i * PAGE_SIZE));
+
+        // Submissions rejected while the engine is full are counted
+        WAIT_UNTIL(((trans_id = idma_submit(dma_ut)) != 0) || ((*rejected)++, false),
+                    WAIT_BUDGET, "iDMA pipelined transfer accepted");
+
+        ids[(oldest + in_flight) % PIPE_MAX_DEPTH] = trans_id;
+        in_flight++;
+    }
+
+    // Transfers complete in order: waiting for the last one drains the pipeline
+    idma_wait(dma_ut, trans_id);
+
+    return (CSRR(CSR_CYCLES) - stamp_start);
+}
+
+/**
+ *  Pipelined translation throughput
+ *
+ *  Issue PIPE_N_XFERS transfers, each touching a different pair of 4-kiB pages, through two-stage
+ *  translation with 1..PIPE_MAX_DEPTH transfers in flight. Each depth is run with empty IOTLB/DDTC
+ *  (cold) and then again with the translations cached (warm).
+ *  Depth 1 is equivalent to serialized idma_exec_transfer() calls.
+ */
+bool dma_pipelined_throughput(){
+
+    BENCH_START();
+
+    size_t idma_idx = 0;
+    struct idma *dma_ut = (void*)idma_addr[idma_idx];
+
+    fence_i();
+    set_iommu_1lvl();
+    rv_iommu_set_iosatp_sv39();
+    rv_iommu_set_iohgatp_sv39x4();
+    VERBOSE("IOMMU 1LVL mode | iohgatp: Sv39x4 | iosatp: Sv39");
+
+    static const char* pass_strs[] = {"cold", "warm"};
+    bool check = true;
+
+    for (size_t d = 0; d < PIPE_N_DEPTHS; d++)
+    {
+        //# Start from empty DDTC and IOTLB
+        bench_inval_all();
+
+        for (size_t pass = 0; pass < 2; pass++)
+        {
+            uint64_t rejected = 0;
+
+            pipe_init();
+
+            uint64_t iotlb_miss = rv_iommu_get_iohpmctr(HPM_CTR_IOTLB_MISS);
+            uint64_t cycles = pipe_run(dma_ut, pipe_depths[d], &rejected);
+            iotlb_miss = rv_iommu_get_iohpmctr(HPM_CTR_IOTLB_MISS) - iotlb_miss;
+
+            check = pipe_check() && check;
+
+            BENCH_REPORT_RATIO("B/cycle", PIPE_N_XFERS * PIPE_XFER_SIZE, cycles,
+                                "depth_%d.%s.throughput", (int)pipe_depths[d], pass_strs[pass]);
+            BENCH_REPORT("cycles", cycles / PIPE_N_XFERS,
+                                "depth_%d.%s.cycles_per_xfer", (int)pipe_depths[d], pass_strs[pass]);
+            BENCH_REPORT("events", iotlb_miss,
+                                "depth_%d.%s.iotlb_miss", (int)pipe_depths[d], pass_strs[pass]);
+            BENCH_REPORT("events", rejected,
+                                "depth_%d.%s.rejected_submits", (int)pipe_depths[d], pass_strs[pass]);
+        }
+    }
+
+    TEST_ASSERT("Pipelined DMA: all transfers match", check);
+
+    TEST_END();
+}
+
+/**********************************************************************************************/
+
+// Translation configurations of the bandwidth sweep
+enum bw_mode {
+    BW_IOMMU_BARE,      // IOMMU in Bare mode (baseline, equivalent to the iDMA-only SoC)
+    BW_STAGES_BARE,     // Both stages in Bare mode
+    BW_S1_ONLY,         // First-stage only (Sv39)
+    BW_S2_ONLY,         // Second-stage only (Sv39x4)
+    BW_TWO_STAGE,       // Two-stage (Sv39/Sv39x4)
+    BW_MODE_MAX
+};
+
+static const char* bw_mode_strs[] = {
+    [BW_IOMMU_BARE]     = "iommu_bare",
+    [BW_STAGES_BARE]    = "stages_bare",
+    [BW_S1_ONLY]        = "s1_only",
+    [BW_S2_ONLY]        = "s2_only",
+    [BW_TWO_STAGE]      = "two_stage",
+};
+
+// Page size of the mappings
+enum bw_pgsz {
+    BW_4K,
+    BW_2M,
+    BW_1G,
+    BW_PGSZ_MAX
+};
+
+static const char* bw_pgsz_strs[] = {
+    [BW_4K]             = "4k",
+    [BW_2M]             = "2m",
+    [BW_1G]             = "1g",
+};
+
+// Sweep cases. Source and destination offsets are relative to the two halves of the benchmark window
+static const struct {
+    uint64_t size;
+    uint64_t src_off;
+    uint64_t dst_off;
+    const char* tag;
+} bw_cases[] = {
+    {8ULL,              0ULL,           0ULL,           "8B"},
+    {64ULL,             0ULL,           0ULL,           "64B"},
+    {512ULL,            0ULL,           0ULL,           "512B"},
+    {4096ULL,           0ULL,           0ULL,           "4KiB"},
+    {32768ULL,          0ULL,           0ULL,           "32KiB"},
+    {262144ULL,         0ULL,           0ULL,           "256KiB"},
+    {2097152ULL,        0ULL,           0ULL,           "2MiB"},
+    {4194304ULL,        0ULL,           0ULL,           "4MiB"},
+    {8ULL,              4092ULL,        4092ULL,        "8B_page_cross"},
+    {4096ULL,           2048ULL,        2048ULL,        "4KiB_page_cross"},
+    {4096ULL,           3ULL,           5ULL,           "4KiB_misaligned"},
+    {65536ULL,          2097152ULL-4096ULL, 2097152ULL-4096ULL, "64KiB_2MiB_cross"},
+    {262147ULL,         1ULL,           7ULL,           "256KiB_misaligned"},
+};
+#define BW_N_CASES      (sizeof(bw_cases)/sizeof(bw_cases[0]))
+
+// Bytes moved per measurement (the transfer is repeated until reaching this amount)
+#define BW_BYTES_PER_POINT  (1ULL << 20)
+#define BW_MAX_REPS         (64)
+
+// Offset of the destination half of the benchmark window
+#define BW_DST_OFF      (BENCH_WINDOW_SIZE / 2)
+
+/**
+ *  Configure the IOMMU for a given translation mode
+ */
+static void bw_set_mode(enum bw_mode mode)
+{
+    static const enum iommu_fixture bw_fixtures[] = {
+        [BW_IOMMU_BARE]     = FX_BARE,
+        [BW_STAGES_BARE]    = FX_STAGES_BARE,
+        [BW_S1_ONLY]        = FX_S1_ONLY,
+        [BW_S2_ONLY]        = FX_S2_ONLY,
+        [BW_TWO_STAGE]      = FX_TWO_STAGE,
+    };
+
+    rv_iommu_fixture(bw_fixtures[mode]);
+}
+
+/**
+ *  Returns the IOVA of the byte at offset 'off' of the benchmark window,
+ *  for a given translation mode and page size
+ */
+static uintptr_t bw_iova(enum bw_mode mode, enum bw_pgsz pgsz, uint64_t off)
+{
+    // Modes without translation use SPAs
+    if (mode == BW_IOMMU_BARE || mode == BW_STAGES_BARE || pgsz == BW_1G)
+        return (BENCH_VADDR_1GIB_BASE + off);
+
+    if (mode == BW_S1_ONLY)
+        return (((pgsz == BW_4K) ? (BENCH_S1_VADDR_BASE) : (BENCH_S1_VADDR_2MIB_BASE)) + off);
+
+    return (((pgsz == BW_4K) ? (BENCH_VADDR_BASE) : (BENCH_VADDR_2MIB_BASE)) + off);
+}
+
+/**
+ *  DMA bandwidth sweep
+ *
+ *  Sweep transfer sizes from 8 B to 4 MiB, including page-crossing and misaligned cases, under
+ *  each translation mode and page size. Each point starts with empty DDTC and IOTLB: the first
+ *  transfer is reported as cold latency, and the transfer is then repeated to measure bandwidth.
+ *  Overhead is reported as the ratio of cycles w.r.t. the IOMMU in Bare mode (baseline).
+ *  IOMMU OFF mode is not included, since all transfers fault.
+ */
+bool dma_bandwidth_sweep(){
+
+    BENCH_START();
+
+    size_t idma_idx = 0;
+    struct idma *dma_ut = (void*)idma_addr[idma_idx];
+
+    uint64_t base_cycles[BW_N_CASES];
+    bool check = true;
+
+    //# Fill the source half of the window with a known pattern
+    for (uint64_t off = 0; off < BW_DST_OFF; off += 8)
+        write64(bench_paddr(off), 0xB0B0000000000000ULL | off);
+
+    fence_i();
+
+    for (int mode = 0; mode < BW_MODE_MAX; mode++)
+    {
+        // Modes without translation do not depend on page size
+        int n_pgsz = (mode == BW_IOMMU_BARE || mode == BW_STAGES_BARE) ? (1) : (BW_PGSZ_MAX);
+
+        bw_set_mode(mode);
+
+        for (int pgsz = 0; pgsz < n_pgsz; pgsz++)
+        {
+            const char *pgsz_str = (n_pgsz == 1) ? ("na") : (bw_pgsz_strs[pgsz]);
+
+            for (size_t c = 0; c < BW_N_CASES; c++)
+            {
+                uint64_t size = bw_cases[c].size;
+                uint64_t src_off = bw_cases[c].src_off;
+                uint64_t dst_off = BW_DST_OFF + bw_cases[c].dst_off;
+                uint64_t reps = BW_BYTES_PER_POINT / size;
+                reps = (reps < 1) ? (1) : ((reps > BW_MAX_REPS) ? (BW_MAX_REPS) : (reps));
+
+                //# Clear destination and start from empty DDTC and IOTLB
+                memset((void*)bench_paddr(dst_off), 0, size);
+                fence_i();
+
+                bench_inval_all();
+
+                idma_setup(dma_ut, bw_iova(mode, pgsz, src_off), bw_iova(mode, pgsz, dst_off), size);
+
+                //# Cold transfer
+                uint64_t stamp_start = CSRR(CSR_CYCLES);
+                if (idma_exec_transfer(dma_ut) != 0)
+                    {ERROR("iDMA misconfigured")}
+                uint64_t cold_cycles = CSRR(CSR_CYCLES) - stamp_start;
+
+                //# Warm transfers
+                stamp_start = CSRR(CSR_CYCLES);
+                for (uint64_t r = 0; r < reps; r++)
+                {
+                    if (idma_exec_transfer(dma_ut) != 0)
+                        {ERROR("iDMA misconfigured")}
+                }
+                uint64_t cycles = CSRR(CSR_CYCLES) - stamp_start;
+
+                fence_i();
+                check = (memcmp((void*)bench_paddr(dst_off), (void*)bench_paddr(src_off), size) == 0) && check;
+
+                if (mode == BW_IOMMU_BARE)
+                    base_cycles[c] = cycles;
+
+                BENCH_REPORT("cycles", cold_cycles, "%s.%s.%s.cold_latency",
+                                bw_mode_strs[mode], pgsz_str, bw_cases[c].tag);
+                BENCH_REPORT_RATIO("B/cycle", size * reps, cycles, "%s.%s.%s.bandwidth",
+                                bw_mode_strs[mode], pgsz_str, bw_cases[c].tag);
+                BENCH_REPORT_RATIO("x_overhead", cycles, base_cycles[c], "%s.%s.%s.overhead",
+                                bw_mode_strs[mode], pgsz_str, bw_cases[c].tag);
+            }
+        }
+    }
+
+    TEST_ASSERT("DMA bandwidth sweep: all transfers match", check);
+
+    TEST_END();
+}
+
+/**********************************************************************************************/
+
+// Number of transfers per completion mode
+#define CM_N_XFERS      (64)
+
+// Bytes per transfer
+#define CM_XFER_SIZE    (4096)
+
+/**
+ *  Report min/avg/max latency and jitter (max-min and mean absolute deviation) of a latency sample
+ */
+static void cm_report_lat(const char *test, const char *mode, uint64_t *lat, size_t n)
+{
+    uint64_t min = UINT64_MAX, max = 0, sum = 0, dev = 0;
+
+    for (size_t i = 0; i < n; i++)
+    {
+        sum += lat[i];
+        min = (lat[i] < min) ? (lat[i]) : (min);
+        max = (lat[i] > max) ? (lat[i]) : (max);
+    }
+
+    uint64_t avg = sum / n;
+
+    for (size_t i = 0; i < n; i++)
+        dev += (lat[i] > avg) ? (lat[i] - avg) : (avg - lat[i]);
+
+    bench_report(test, "cycles", min, "%s.lat_min", mode);
+    bench_report(test, "cycles", avg, "%s.lat_avg", mode);
+    bench_report(test, "cycles", max, "%s.lat_max", mode);
+    bench_report(test, "cycles", max - min, "%s.jitter_range", mode);
+    bench_report(test, "cycles", dev / n, "%s.jitter_mad", mode);
+}
+
+/**
+ *  Polled vs interrupt-driven iDMA completion
+ *
+ *  Issue CM_N_XFERS serialized transfers through two-stage translation (warm IOTLB) and wait for
+ *  completion either polling last_transfer_id_complete or sleeping in wfi until the completion
+ *  interrupt. Reports latency jitter and the number of MMIO accesses issued to the iDMA/PLIC
+ *  per transfer, as a measure of interconnect pressure.
+ *  The interrupt-driven mode requires IDMA_IRQ_EN.
+ */
+bool dma_completion_modes(){
+
+    BENCH_START();
+
+    size_t idma_idx = 0;
+    struct idma *dma_ut = (void*)idma_addr[idma_idx];
+
+    uint64_t lat[CM_N_XFERS];
+    uint64_t wake[CM_N_XFERS];
+
+    fence_i();
+    set_iommu_1lvl();
+    rv_iommu_set_iosatp_sv39();
+    rv_iommu_set_iohgatp_sv39x4();
+    VERBOSE("IOMMU 1LVL mode | iohgatp: Sv39x4 | iosatp: Sv39");
+
+    bench_inval_all();
+
+    //# Warm up DDTC and IOTLB
+    idma_setup(dma_ut, bench_vaddr(0), bench_vaddr(BENCH_WINDOW_SIZE / 2), CM_XFER_SIZE);
+    if (idma_exec_transfer(dma_ut) != 0)
+        {ERROR("iDMA misconfigured")}
+
+    //# Polled completion
+    uint64_t polls = 0;
+    for (size_t i = 0; i < CM_N_XFERS; i++)
+    {
+        uint64_t stamp_start = CSRR(CSR_CYCLES);
+        uint64_t trans_id = idma_submit(dma_ut);
+        if (!trans_id)
+            {ERROR("iDMA misconfigured")}
+
+        WAIT_UNTIL((polls++, idma_is_complete(dma_ut, trans_id)), WAIT_BUDGET, "iDMA completion (polled)");
+
+        lat[i] = CSRR(CSR_CYCLES) - stamp_start;
+    }
+
+    cm_report_lat(__test_name, "polled", lat, CM_N_XFERS);
+    // One MMIO read to launch the transfer plus one read per poll
+    BENCH_REPORT_RATIO("accesses", CM_N_XFERS + polls, CM_N_XFERS, "polled.mmio_per_xfer");
+
+    if (!IDMA_IRQ_EN)
+    {
+        VERBOSE("iDMA interrupts disabled (IDMA_IRQ_EN): skipping interrupt-driven completion");
+    }
+    else
+    {
+        //# Interrupt-driven completion
+        idma_irq_init();
+
+        bool check = true;
+        uint64_t mmio_start = mmio_stats_count();
+        for (size_t i = 0; i < CM_N_XFERS; i++)
+        {
+            uint64_t stamp_start = CSRR(CSR_CYCLES);
+            uint64_t trans_id = idma_submit(dma_ut);
+            if (!trans_id)
+                {ERROR("iDMA misconfigured")}
+
+            idma_wait_irq(dma_ut, trans_id);
+
+            wake[i] = CSRR(CSR_CYCLES) - stamp_start;
+            lat[i] = idma_irq_stamp(dma_ut, trans_id) - stamp_start;
+            check = (lat[i] <= wake[i]) && check;
+        }
+
+        uint64_t n_irqs = idma_irq_count;
+        uint64_t n_mmio = mmio_stats_count() - mmio_start;
+        idma_irq_deinit();
+
+        TEST_ASSERT("Interrupt-driven completion: completion recorded before wake-up", check);
+
+        check = (n_irqs <= CM_N_XFERS);
+        TEST_ASSERT("Interrupt-driven completion: at most one interrupt per transfer", check);
+
+        cm_report_lat(__test_name, "irq", lat, CM_N_XFERS);
+        cm_report_lat(__test_name, "irq_wakeup", wake, CM_N_XFERS);
+        BENCH_REPORT("events", n_irqs, "irq.interrupts");
+        // iDMA/IOMMU accesses counted by MMIO_STATS (PLIC accesses are not included)
+        if (MMIO_STATS)
+            BENCH_REPORT_RATIO("accesses", n_mmio, CM_N_XFERS, "irq.mmio_per_xfer");
+    }
+
+    TEST_END();
+}
+
+/**********************************************************************************************/
+
+// Number of fragments of the scatter-gather list and bytes per fragment (Ethernet MTU-sized)
+#define SG_N_FRAGS      (256)
+#define SG_FRAG_SIZE    (1536)
+
+// Offset of the gather buffer within the benchmark window
+#define SG_DST_OFF      (BENCH_WINDOW_SIZE / 2)
+
+enum sg_method {
+    SG_PER_SEGMENT,     // idma_setup() + idma_exec_transfer() per fragment
+    SG_CHAINED,         // idma_sg_exec()
+    SG_CONTIGUOUS,      // Single transfer of the same size (upper bound)
+    SG_METHOD_MAX
+};
+
+static const char* sg_method_strs[] = {
+    [SG_PER_SEGMENT]    = "per_segment",
+    [SG_CHAINED]        = "chained",
+    [SG_CONTIGUOUS]     = "contiguous",
+};
+
+static struct idma_sg_seg sg_list[SG_N_FRAGS];
+
+/**
+ *  Build a gather list: each fragment lives in a different 4-kiB page at a varying offset,
+ *  and all fragments are gathered into a contiguous buffer
+ */
+static void sg_init(void)
+{
+    for (size_t i = 0; i < SG_N_FRAGS; i++)
+    {
+        uint64_t src_off = (i * PAGE_SIZE) + ((i * 256) % (PAGE_SIZE - SG_FRAG_SIZE));
+        uint64_t dst_off = SG_DST_OFF + (i * SG_FRAG_SIZE);
+
+        sg_list[i].src = bench_vaddr(src_off);
+        sg_list[i].dst = bench_vaddr(dst_off);
+        sg_list[i].len = SG_FRAG_SIZE;
+
+        for (uint64_t off = 0; off < SG_FRAG_SIZE; off += 8)
+            write64(bench_paddr(src_off + off), (i << 32) | off);
+    }
+
+    fence_i();
+}
+
+/**
+ *  Check that the gather buffer holds all fragments in order
+ */
+static bool sg_check(void)
+{
+    fence_i();
+
+    for (size_t i = 0; i < SG_N_FRAGS; i++)
+    {
+        uintptr_t src = bench_paddr(sg_list[i].src - BENCH_VADDR_BASE);
+        uintptr_t dst = bench_paddr(sg_list[i].dst - BENCH_VADDR_BASE);
+
+        if (memcmp((void*)dst, (void*)src, SG_FRAG_SIZE) != 0)
+            return false;
+    }
+
+    return true;
+}
+
+/**
+ *  Scatter-gather DMA bandwidth
+ *
+ *  Gather SG_N_FRAGS packet fragments of SG_FRAG_SIZE bytes, scattered across 4-kiB pages, into a
+ *  contiguous buffer through two-stage translation. Compares a full setup/wait round trip per
+ *  segment against streaming the list with idma_sg_exec(), using a single contiguous transfer of
+ *  the same size as upper bound. Each method runs with empty IOTLB/DDTC (cold) and then warm.
+ */
+bool dma_sg_bandwidth(){
+
+    BENCH_START();
+
+    size_t idma_idx = 0;
+    struct idma *dma_ut = (void*)idma_addr[idma_idx];
+
+    static const char* pass_strs[] = {"cold", "warm"};
+    uint64_t bytes = SG_N_FRAGS * SG_FRAG_SIZE;
+    bool check = true;
+
+    fence_i();
+    set_iommu_1lvl();
+    rv_iommu_set_iosatp_sv39();
+    rv_iommu_set_iohgatp_sv39x4();
+    VERBOSE("IOMMU 1LVL mode | iohgatp: Sv39x4 | iosatp: Sv39");
+
+    sg_init();
+
+    for (int method = 0; method < SG_METHOD_MAX; method++)
+    {
+        //# Start from empty DDTC and IOTLB
+        bench_inval_all();
+
+        for (size_t pass = 0; pass < 2; pass++)
+        {
+            memset((void*)bench_paddr(SG_DST_OFF), 0, bytes);
+            fence_i();
+
+            uint64_t stamp_start = CSRR(CSR_CYCLES);
+
+            switch (method)
+            {
+                case SG_PER_SEGMENT:
+                    for (size_t i = 0; i < SG_N_FRAGS; i++)
+                    {
+                        idma_setup(dma_ut, sg_list[i].src, sg_list[i].dst, sg_list[i].len);
+                        if (idma_exec_transfer(dma_ut) != 0)
+                            {ERROR("iDMA misconfigured")}
+                    }
+                    break;
+                case SG_CHAINED:
+                    idma_sg_exec(dma_ut, sg_list, SG_N_FRAGS);
+                    break;
+                default:
+                    idma_setup(dma_ut, bench_vaddr(0), bench_vaddr(SG_DST_OFF), bytes);
+                    if (idma_exec_transfer(dma_ut) != 0)
+                        {ERROR("iDMA misconfigured")}
+                    break;
+            }
+
+            uint64_t cycles = CSRR(CSR_CYCLES) - stamp_start;
+
+            // The contiguous transfer does not gather the fragments
+            if (method != SG_CONTIGUOUS)
+                check = sg_check() && check;
+
+            BENCH_REPORT_RATIO("B/cycle", bytes, cycles, "%s.%s.bandwidth",
+                                sg_method_strs[method], pass_strs[pass]);
+            BENCH_REPORT("cycles", cycles / SG_N_FRAGS, "%s.%s.cycles_per_frag",
+                                sg_method_strs[method], pass_strs[pass]);
+        }
+    }
+
+    TEST_ASSERT("Scatter-gather DMA: gathered buffer matches fragments", check);
+
+    TEST_END();
+}
+
+/**********************************************************************************************/
+
+#if (WL_MAX_PAGES > BENCH_N_PAGES)
+#   error "Workload working set larger than the benchmark window"
+#endif
+
+// Number of translations per workload
+#define WLB_N_ACCESSES  (4096)
+
+// Number of devices issuing translations (device IDs DID_MIN + i)
+#define WLB_N_DEVICES   (4)
+
+static const size_t wlb_ws_sizes[] = {64, 512, WL_MAX_PAGES};
+#define WLB_N_WS        (sizeof(wlb_ws_sizes)/sizeof(wlb_ws_sizes[0]))
+
+/**
+ *  IOTLB behaviour under different access patterns
+ *
+ *  Translate WLB_N_ACCESSES IOVAs of the benchmark window through the debug interface with
+ *  two-stage translation, following each workload pattern with working sets of 64 to 4096 pages
+ *  and WLB_N_DEVICES devices. Each run starts with empty DDTC and IOTLB.
+ *  The PRNG is seeded with WL_SEED, so runs are reproducible.
+ */
+bool translation_workloads(){
+
+    BENCH_START();
+
+    fence_i();
+    set_iommu_1lvl();
+    rv_iommu_set_iosatp_sv39();
+    rv_iommu_set_iohgatp_sv39x4();
+    VERBOSE("IOMMU 1LVL mode | iohgatp: Sv39x4 | iosatp: Sv39");
+
+    static struct workload wl;
+    static struct bench_hist hist;
+    bool check = true;
+
+    for (int pattern = 0; pattern < WL_PATTERN_MAX; pattern++)
+    {
+        for (size_t w = 0; w < WLB_N_WS; w++)
+        {
+            struct workload_cfg cfg = {
+                .pattern        = pattern,
+                .n_pages        = wlb_ws_sizes[w],
+                .stride         = 17,
+                .zipf_s         = 1,
+                .phase_len      = WLB_N_ACCESSES / 8,
+                .phase_pages    = wlb_ws_sizes[w] / 8,
+                .n_devices      = WLB_N_DEVICES,
+                .device_weights = NULL,
+                .seed           = WL_SEED,
+            };
+
+            workload_init(&wl, &cfg);
+            bench_hist_reset(&hist);
+
+            //# Start from empty DDTC and IOTLB
+            bench_inval_all();
+
+            uint64_t iotlb_miss = rv_iommu_get_iohpmctr(HPM_CTR_IOTLB_MISS);
+            uint64_t ddtw = rv_iommu_get_iohpmctr(HPM_CTR_DDTW);
+
+            for (size_t i = 0; i < WLB_N_ACCESSES; i++)
+            {
+                struct wl_access acc;
+                workload_next(&wl, &acc);
+
+                uint64_t iova = bench_vaddr(acc.page * PAGE_SIZE);
+                uint64_t stamp_start = CSRR(CSR_CYCLES);
+                check = bench_dbg_translate(DID_MIN + acc.device, iova) && check;
+                bench_hist_add(&hist, CSRR(CSR_CYCLES) - stamp_start);
+            }
+
+            iotlb_miss = rv_iommu_get_iohpmctr(HPM_CTR_IOTLB_MISS) - iotlb_miss;
+            ddtw = rv_iommu_get_iohpmctr(HPM_CTR_DDTW) - ddtw;
+
+            BENCH_REPORT_RATIO("misses/req", iotlb_miss, WLB_N_ACCESSES, "%s.ws_%d.iotlb_miss_rate",
+                                wl_pattern_strs[pattern], (int)wlb_ws_sizes[w]);
+            BENCH_REPORT("events", ddtw, "%s.ws_%d.ddt_walks",
+                                wl_pattern_strs[pattern], (int)wlb_ws_sizes[w]);
+            BENCH_REPORT_HIST("cycles", &hist, "%s.ws_%d.latency",
+                                wl_pattern_strs[pattern], (int)wlb_ws_sizes[w]);
+        }
+    }
+
+    TEST_ASSERT("Workloads: all translations completed without faults", check);
+
+    TEST_END();
+}
+
+/**********************************************************************************************/
+
+// Number of measured transfers per cache state
+#define CT_N_SAMPLES    (64)
+
+// Bytes per measured transfer
+#define CT_XFER_SIZE    (8)
+
+/**
+ *  Latency per IOMMU cache tier
+ *
+ *  Each measured transfer reads from and writes to a different pair of pages of the benchmark window
+ *  through two-stage translation, preconditioned to one of three states:
+ *  fully cold (DDTC and IOTLB invalidated and fenced), IOTLB-cold with the DC cached, and fully warm.
+ *  Reports the latency distribution of each state and the cost of each tier (difference of medians).
+ *  HPM counters are used to check that each sample really ran in the intended state.
+ */
+bool cache_tier_latency(){
+
+    BENCH_START();
+
+    size_t idma_idx = 0;
+    struct idma *dma_ut = (void*)idma_addr[idma_idx];
+
+    static struct bench_hist hist[CS_MAX];
+    uint64_t p50[CS_MAX];
+    bool check = true;
+
+    fence_i();
+    set_iommu_1lvl();
+    rv_iommu_set_iosatp_sv39();
+    rv_iommu_set_iohgatp_sv39x4();
+    VERBOSE("IOMMU 1LVL mode | iohgatp: Sv39x4 | iosatp: Sv39");
+
+    for (int state = 0; state < CS_MAX; state++)
+    {
+        size_t mismatches = 0;
+        bench_hist_reset(&hist[state]);
+
+        for (size_t i = 0; i < CT_N_SAMPLES; i++)
+        {
+            uint64_t src_off = i * PAGE_SIZE;
+            uint64_t dst_off = (BENCH_WINDOW_SIZE / 2) + (i * PAGE_SIZE);
+
+            write64(bench_paddr(src_off), 0xCAFE0000ULL | i);
+            write64(bench_paddr(dst_off), 0);
+            fence_i();
+
+            idma_setup(dma_ut, bench_vaddr(src_off), bench_vaddr(dst_off), CT_XFER_SIZE);
+            bench_precondition(state, dma_ut);
+
+            uint64_t iotlb_miss = rv_iommu_get_iohpmctr(HPM_CTR_IOTLB_MISS);
+            uint64_t ddtw = rv_iommu_get_iohpmctr(HPM_CTR_DDTW);
+
+            uint64_t stamp_start = CSRR(CSR_CYCLES);
+            if (idma_exec_transfer(dma_ut) != 0)
+                {ERROR("iDMA misconfigured")}
+            bench_hist_add(&hist[state], CSRR(CSR_CYCLES) - stamp_start);
+
+            iotlb_miss = rv_iommu_get_iohpmctr(HPM_CTR_IOTLB_MISS) - iotlb_miss;
+            ddtw = rv_iommu_get_iohpmctr(HPM_CTR_DDTW) - ddtw;
+
+            //# Check the state seen by the IOMMU
+            switch (state)
+            {
+                case CS_COLD:       mismatches += (ddtw == 0 || iotlb_miss == 0);   break;
+                case CS_IOTLB_COLD: mismatches += (ddtw != 0 || iotlb_miss == 0);   break;
+                default:            mismatches += (ddtw != 0 || iotlb_miss != 0);   break;
+            }
+
+            fence_i();
+            check = (read64(bench_paddr(dst_off)) == (0xCAFE0000ULL | i)) && check;
+        }
+
+        p50[state] = bench_hist_quantile(&hist[state], 50, 100);
+
+        BENCH_REPORT_HIST("cycles", &hist[state], "%s.latency", cache_state_strs[state]);
+        BENCH_REPORT("samples", mismatches, "%s.state_mismatches", cache_state_strs[state]);
+    }
+
+    BENCH_REPORT("cycles", (p50[CS_COLD] > p50[CS_IOTLB_COLD]) ? (p50[CS_COLD] - p50[CS_IOTLB_COLD]) : (0),
+                    "tier.ddtc_miss_cost");
+    BENCH_REPORT("cycles", (p50[CS_IOTLB_COLD] > p50[CS_WARM]) ? (p50[CS_IOTLB_COLD] - p50[CS_WARM]) : (0),
+                    "tier.iotlb_miss_cost");
+
+    TEST_ASSERT("Cache tiers: all transfers match", check);
+
+    TEST_END();
+}
+
+/**********************************************************************************************/
+
+// Translation configurations of the latency matrix
+enum mx_cfg {
+    MX_OFF,             // IOMMU OFF: all transactions blocked (fault path)
+    MX_BARE,            // IOMMU Bare
+    MX_STAGES_BARE,     // 1LVL with both stages in Bare mode
+    MX_S2_4K,           // Second-stage only
+    MX_S2_2M,
+    MX_S2_1G,
+    MX_TWO_STAGE_4K,    // Two-stage
+    MX_TWO_STAGE_2M,
+    MX_TWO_STAGE_1G,
+    MX_MSI_FLAT,        // Second-stage only + MSI translation (flat, basic-translate PTE)
+    MX_MRIF,            // Second-stage only + MSI translation (flat, MRIF PTE)
+    MX_CFG_MAX
+};
+
+static const struct {
+    const char* name;
+    enum bw_mode mode;
+    enum bw_pgsz pgsz;
+} mx_cfgs[] = {
+    [MX_OFF]            = {"off",               BW_IOMMU_BARE,  BW_4K},
+    [MX_BARE]           = {"bare",              BW_IOMMU_BARE,  BW_4K},
+    [MX_STAGES_BARE]    = {"stages_bare",       BW_STAGES_BARE, BW_4K},
+    [MX_S2_4K]          = {"s2_only.4k",        BW_S2_ONLY,     BW_4K},
+    [MX_S2_2M]          = {"s2_only.2m",        BW_S2_ONLY,     BW_2M},
+    [MX_S2_1G]          = {"s2_only.1g",        BW_S2_ONLY,     BW_1G},
+    [MX_TWO_STAGE_4K]   = {"two_stage.4k",      BW_TWO_STAGE,   BW_4K},
+    [MX_TWO_STAGE_2M]   = {"two_stage.2m",      BW_TWO_STAGE,   BW_2M},
+    [MX_TWO_STAGE_1G]   = {"two_stage.1g",      BW_TWO_STAGE,   BW_1G},
+    [MX_MSI_FLAT]       = {"msi_flat",          BW_S2_ONLY,     BW_4K},
+    [MX_MRIF]           = {"mrif",              BW_S2_ONLY,     BW_4K},
+};
+
+// Cache states measured per configuration
+static const enum cache_state mx_states[] = {CS_COLD, CS_WARM};
+#define MX_N_STATES     (sizeof(mx_states)/sizeof(mx_states[0]))
+
+// Number of measured transfers per configuration and bytes per transfer
+#define MX_N_SAMPLES    (32)
+#define MX_XFER_SIZE    (8)
+
+// Bytes of the bulk transfer used to measure throughput
+#define MX_BULK_SIZE    (65536)
+
+// Offset of the destination half of the benchmark window
+#define MX_DST_OFF      (BENCH_WINDOW_SIZE / 2)
+
+/**
+ *  Configure the IOMMU for a matrix configuration
+ */
+static void mx_set_cfg(enum mx_cfg cfg)
+{
+    if (cfg == MX_OFF)
+        set_iommu_off();
+    else
+        bw_set_mode(mx_cfgs[cfg].mode);
+
+    if (cfg == MX_MSI_FLAT || cfg == MX_MRIF)
+        rv_iommu_set_msi_flat();
+    else
+        rv_iommu_set_msi_off();
+}
+
+/**
+ *  Program the iDMA with sample i of a matrix configuration.
+ *  Window configurations use a different pair of 4-kiB pages per sample.
+ *  MSI configurations write to the MSI page associated with each PTE mode
+ */
+static void mx_setup(enum mx_cfg cfg, struct idma *dma_ut, size_t i)
+{
+    switch (cfg)
+    {
+        case MX_OFF:
+            idma_setup(dma_ut, virt_page_base(IOMMU_OFF_R), virt_page_base(IOMMU_OFF_W), MX_XFER_SIZE);
+            break;
+        case MX_MSI_FLAT:
+            idma_setup(dma_ut, virt_page_base(MSI_R1), virt_page_base(MSI_W1), 4);
+            break;
+        case MX_MRIF:
+            idma_setup(dma_ut, virt_page_base(MSI_R3), virt_page_base(MSI_W3), 4);
+            break;
+        default:
+            idma_setup(dma_ut, bw_iova(mx_cfgs[cfg].mode, mx_cfgs[cfg].pgsz, i * PAGE_SIZE),
+                        bw_iova(mx_cfgs[cfg].mode, mx_cfgs[cfg].pgsz, MX_DST_OFF + (i * PAGE_SIZE)), MX_XFER_SIZE);
+            break;
+    }
+}
+
+/**
+ *  Drain the FQ. Returns the number of records read
+ */
+static size_t mx_drain_fq(void)
+{
+    uint64_t fq_entry[4];
+    size_t n = 0;
+
+    while (rv_iommu_fq_read_record(fq_entry) == 0)
+        n++;
+
+    rv_iommu_clear_ipsr_fip();
+
+    return n;
+}
+
+/**
+ *  Translation-mode latency matrix
+ *
+ *  Run the same DMA workload under every translation configuration: IOMMU OFF (blocked path,
+ *  draining the FQ after each transfer), Bare, both stages Bare, second-stage only and two-stage
+ *  with 4-kiB/2-MiB/1-GiB leaves, and MSI translation with basic-translate and MRIF PTEs.
+ *  For each configuration, reports the latency distribution of cold and warm 8-byte transfers,
+ *  back-to-back transfer rate, and bulk throughput (configurations mapping the benchmark window).
+ */
+bool translation_matrix(){
+
+    BENCH_START();
+
+    size_t idma_idx = 0;
+    struct idma *dma_ut = (void*)idma_addr[idma_idx];
+
+    static struct bench_hist hist;
+    size_t off_records = 0;
+    bool check = true;
+
+    //# Known values: window pages, MSI sources and notices
+    for (size_t i = 0; i < MX_N_SAMPLES; i++)
+        write64(bench_paddr(i * PAGE_SIZE), 0xD00D0000ULL | i);
+    write64(phys_page_base(MSI_R1), 0x22);
+    write32(phys_page_base(MSI_R3), INT_ID_1);
+    fence_i();
+
+    for (int cfg = 0; cfg < MX_CFG_MAX; cfg++)
+    {
+        fence_i();
+        mx_set_cfg(cfg);
+
+        for (size_t s = 0; s < MX_N_STATES; s++)
+        {
+            enum cache_state state = mx_states[s];
+            bench_hist_reset(&hist);
+
+            for (size_t i = 0; i < MX_N_SAMPLES; i++)
+            {
+                mx_setup(cfg, dma_ut, i);
+                bench_precondition(state, dma_ut);
+
+                if (cfg == MX_OFF)
+                    mx_drain_fq();
+
+                uint64_t stamp_start = CSRR(CSR_CYCLES);
+                if (idma_exec_transfer(dma_ut) != 0)
+                    {ERROR("iDMA misconfigured")}
+                bench_hist_add(&hist, CSRR(CSR_CYCLES) - stamp_start);
+
+                if (cfg == MX_OFF)
+                    off_records += mx_drain_fq();
+            }
+
+            BENCH_REPORT_HIST("cycles", &hist, "%s.%s", mx_cfgs[cfg].name, cache_state_strs[state]);
+        }
+
+        //# Back-to-back transfers (warm)
+        uint64_t stamp_start = CSRR(CSR_CYCLES);
+        for (size_t i = 0; i < MX_N_SAMPLES; i++)
+        {
+            mx_setup(cfg, dma_ut, i);
+            if (idma_exec_transfer(dma_ut) != 0)
+                {ERROR("iDMA misconfigured")}
+        }
+        uint64_t cycles = CSRR(CSR_CYCLES) - stamp_start;
+
+        BENCH_REPORT_RATIO("xfers/kcycle", MX_N_SAMPLES * 1000, cycles, "%s.rate", mx_cfgs[cfg].name);
+
+        if (cfg == MX_OFF)
+        {
+            off_records += mx_drain_fq();
+            continue;
+        }
+
+        if (cfg == MX_MSI_FLAT || cfg == MX_MRIF)
+            continue;
+
+        //# Check the last window transfer
+        fence_i();
+        check = (read64(bench_paddr(MX_DST_OFF + ((MX_N_SAMPLES - 1) * PAGE_SIZE))) ==
+                    (0xD00D0000ULL | (MX_N_SAMPLES - 1))) && check;
+
+        //# Bulk throughput (warm)
+        idma_setup(dma_ut, bw_iova(mx_cfgs[cfg].mode, mx_cfgs[cfg].pgsz, 0),
+                    bw_iova(mx_cfgs[cfg].mode, mx_cfgs[cfg].pgsz, MX_DST_OFF), MX_BULK_SIZE);
+        bench_precondition(CS_WARM, dma_ut);
+
+        stamp_start = CSRR(CSR_CYCLES);
+        if (idma_exec_transfer(dma_ut) != 0)
+            {ERROR("iDMA misconfigured")}
+        cycles = CSRR(CSR_CYCLES) - stamp_start;
+
+        BENCH_REPORT_RATIO("B/cycle", MX_BULK_SIZE, cycles, "%s.bulk_throughput", mx_cfgs[cfg].name);
+    }
+
+    BENCH_REPORT("records", off_records, "off.fq_records");
+
+    TEST_ASSERT("Translation matrix: window transfers match", check);
+
+    check = (off_records != 0);
+    TEST_ASSERT("Translation matrix: IOMMU OFF transfers recorded in the FQ", check);
+
+    //# Restore MSI translation and MRIF state
+    rv_iommu_set_msi_off();
+    mrif_init();
+    write32((uintptr_t)NOTICE_ADDR_1, 0);
+    bench_inval_all();
+
+    TEST_END();
+}
+
+/**********************************************************************************************/
+
+// DMA transfers per measurement and bytes per transfer
+#define CC_N_XFERS      (256)
+#define CC_XFER_SIZE    (4096)
+
+// One in CC_FAULT_PERIOD transfers reads a page with an invalid first-stage PTE, to feed the FQ
+#define CC_FAULT_PERIOD (16)
+#define CC_N_FAULTS     (CC_N_XFERS / CC_FAULT_PERIOD)
+
+// Offset of the destination half of the benchmark window
+#define CC_DST_OFF      (BENCH_WINDOW_SIZE / 2)
+
+// Roles of the secondary harts (role r runs on hart r+1, if present)
+enum cc_role {
+    CC_INVAL,           // Push IOTINVAL.VMA + IOFENCE.C through the CQ
+    CC_FQ,              // Drain the FQ
+    CC_N_ROLES
+};
+
+// Operations completed by a secondary hart and cycles it was active
+struct cc_worker {
+    uint64_t ops;
+    uint64_t cycles;
+};
+
+static volatile bool cc_stop;
+static struct cc_worker cc_workers[CC_N_ROLES];
+
+/**
+ *  Invalidation worker: address-specific IOTINVAL.VMA over the benchmark window, each followed by IOFENCE.C
+ */
+static void cc_inval_worker(void *arg)
+{
+    struct cc_worker *w = arg;
+    uint64_t stamp_start = CSRR(CSR_CYCLES);
+
+    for (uint64_t i = 0; !cc_stop; i++)
+    {
+        rv_iommu_iotinval_vma(true, false, false, bench_vaddr((i * PAGE_SIZE) % CC_DST_OFF), 0, 0);
+        rv_iommu_cq_sync();
+        w->ops++;
+    }
+
+    w->cycles = CSRR(CSR_CYCLES) - stamp_start;
+}
+
+/**
+ *  FQ worker: read fault records as soon as they are written
+ */
+static void cc_fq_worker(void *arg)
+{
+    struct cc_worker *w = arg;
+    uint64_t fq_entry[4];
+    uint64_t stamp_start = CSRR(CSR_CYCLES);
+
+    while (!cc_stop)
+    {
+        if (rv_iommu_fq_read_record(fq_entry) == 0)
+            w->ops++;
+    }
+
+    w->cycles = CSRR(CSR_CYCLES) - stamp_start;
+}
+
+static const hart_func_t cc_roles[CC_N_ROLES] = {
+    [CC_INVAL]  = cc_inval_worker,
+    [CC_FQ]     = cc_fq_worker,
+};
+
+/**
+ *  Run the DMA workload on the primary hart. Returns the number of cycles
+ */
+static uint64_t cc_dma_run(struct idma *dma_ut)
+{
+    uint64_t stamp_start = CSRR(CSR_CYCLES);
+
+    for (size_t i = 0; i < CC_N_XFERS; i++)
+    {
+        uint64_t off = i * CC_XFER_SIZE;
+
+        if ((i % CC_FAULT_PERIOD) == (CC_FAULT_PERIOD - 1))
+            idma_setup(dma_ut, virt_page_base(S2_ONLY_R), bench_vaddr(CC_DST_OFF + off), 8);
+        else
+            idma_setup(dma_ut, bench_vaddr(off), bench_vaddr(CC_DST_OFF + off), CC_XFER_SIZE);
+
+        if (idma_exec_transfer(dma_ut) != 0)
+            {ERROR("iDMA misconfigured")}
+    }
+
+    return (CSRR(CSR_CYCLES) - stamp_start);
+}
+
+/**
+ *  Check the destination of the non-faulting transfers, and clear it for the next run
+ */
+static bool cc_check(void)
+{
+    bool check = true;
+
+    fence_i();
+    for (size_t i = 0; i < CC_N_XFERS; i++)
+    {
+        uint64_t off = i * CC_XFER_SIZE;
+
+        if ((i % CC_FAULT_PERIOD) != (CC_FAULT_PERIOD - 1))
+            check = (memcmp((void*)bench_paddr(CC_DST_OFF + off), (void*)bench_paddr(off), CC_XFER_SIZE) == 0) && check;
+    }
+
+    memset((void*)bench_paddr(CC_DST_OFF), 0, CC_N_XFERS * CC_XFER_SIZE);
+    fence_i();
+
+    return check;
+}
+
+/**
+ *  Concurrent driver load
+ *
+ *  Run a two-stage DMA workload (4-kiB transfers, one in CC_FAULT_PERIOD faulting) on the primary
+ *  hart, first alone and then while secondary harts push address-specific invalidations through
+ *  the CQ and drain the FQ, as an SMP kernel would. Reports DMA bandwidth in both cases, the
+ *  slowdown, and the invalidation and fault record rates of the secondary harts.
+ *  Requires PLAT_N_HARTS >= 2 (the FQ is drained by the primary hart if there is no third hart).
+ */
+bool concurrent_driver_load(){
+
+    BENCH_START();
+
+#if (PLAT_N_HARTS > 1)
+    size_t idma_idx = 0;
+    struct idma *dma_ut = (void*)idma_addr[idma_idx];
+
+    uint64_t bytes = (CC_N_XFERS - CC_N_FAULTS) * CC_XFER_SIZE;
+    bool check = true;
+
+    //# Fill the source half of the window with a known pattern
+    for (uint64_t off = 0; off < CC_N_XFERS * CC_XFER_SIZE; off += 8)
+        write64(bench_paddr(off), 0xCC00000000000000ULL | off);
+
+    memset((void*)bench_paddr(CC_DST_OFF), 0, CC_N_XFERS * CC_XFER_SIZE);
+    fence_i();
+
+    rv_iommu_fixture(FX_TWO_STAGE);
+    mx_drain_fq();
+
+    //# DMA alone
+    bench_inval_all();
+    uint64_t base_cycles = cc_dma_run(dma_ut);
+    size_t base_records = mx_drain_fq();
+    check = cc_check() && check;
+
+    //# DMA with concurrent invalidations and FQ draining
+    bench_inval_all();
+    memset(cc_workers, 0, sizeof(cc_workers));
+    cc_stop = false;
+    __sync_synchronize();
+
+    for (unsigned r = 0; r < CC_N_ROLES && (r + 1) < PLAT_N_HARTS; r++)
+        hart_start(r + 1, cc_roles[r], &cc_workers[r]);
+
+    uint64_t cycles = cc_dma_run(dma_ut);
+
+    cc_stop = true;
+    __sync_synchronize();
+
+    for (unsigned r = 0; r < CC_N_ROLES && (r + 1) < PLAT_N_HARTS; r++)
+        hart_join(r + 1);
+
+    size_t records = cc_workers[CC_FQ].ops + mx_drain_fq();
+    check = cc_check() && check;
+
+    BENCH_REPORT_RATIO("B/cycle", bytes, base_cycles, "dma_alone.bandwidth");
+    BENCH_REPORT_RATIO("B/cycle", bytes, cycles, "dma_concurrent.bandwidth");
+    BENCH_REPORT_RATIO("x_overhead", cycles, base_cycles, "dma_concurrent.slowdown");
+    BENCH_REPORT_RATIO("invals/kcycle", cc_workers[CC_INVAL].ops * 1000, cc_workers[CC_INVAL].cycles, "cq.inval_rate");
+    BENCH_REPORT("invals", cc_workers[CC_INVAL].ops, "cq.invals");
+    BENCH_REPORT("records", cc_workers[CC_FQ].ops, "fq.records_concurrent");
+
+    TEST_ASSERT("Concurrent driver load: all transfers match", check);
+
+    check = (base_records == CC_N_FAULTS) && (records == CC_N_FAULTS);
+    TEST_ASSERT("Concurrent driver load: all faults recorded in the FQ", check);
+
+    bench_inval_all();
+#else
+    INFO("Skipped: requires PLAT_N_HARTS >= 2");
+#endif
+
+    TEST_END();
+}
+
+/**********************************************************************************************/
+
+// Operations per instance and measurement, and pages translated by each instance
+#define MI_N_OPS        (256)
+#define MI_N_PAGES      (16)
+
+// Work of an instance: operations completed, cycles it was active and translation faults
+struct mi_worker {
+    struct rv_iommu *inst;
+    uint64_t ops;
+    uint64_t cycles;
+    uint64_t faults;
+};
+
+static struct mi_worker mi_workers[PLAT_N_IOMMU];
+
+/**
+ *  Instance worker: invalidate a page (IOTINVAL.VMA + IOFENCE.C) and translate it again through
+ *  the debug interface, i.e., an unmap/remap round trip through the CQ and the page table walker
+ */
+static void mi_worker(void *arg)
+{
+    struct mi_worker *w = arg;
+    struct rv_iommu *prev = rv_iommu_selected();
+
+    rv_iommu_select(w->inst);
+    uint64_t stamp_start = CSRR(CSR_CYCLES);
+
+    for (uint64_t i = 0; i < MI_N_OPS; i++)
+    {
+        uint64_t iova = virt_page_base(STRESS_START + (i % MI_N_PAGES));
+
+        rv_iommu_iotinval_vma(true, false, false, iova, 0, 0);
+        rv_iommu_cq_sync();
+        if (!bench_dbg_translate(DID_MIN, iova))
+            w->faults++;
+        w->ops++;
+    }
+
+    w->cycles = CSRR(CSR_CYCLES) - stamp_start;
+
+    rv_iommu_select(prev);
+}
+
+/**
+ *  Multi-instance scaling
+ *
+ *  Drive 1 to min(PLAT_N_IOMMU, PLAT_N_HARTS) IOMMU instances in parallel, instance i from hart i,
+ *  each one running MI_N_OPS invalidate/translate round trips on its own CQ and debug interface.
+ *  All instances share the DDT and page tables (two-stage). Reports the aggregate and per-instance
+ *  operation rates for each number of instances, and the scaling w.r.t. a single instance.
+ *  Secondary instances are set back to IOMMU OFF by rv_iommu_restore() after the test.
+ */
+bool multi_iommu_scaling(){
+
+    BENCH_START();
+
+    size_t n_max = (PLAT_N_IOMMU < PLAT_N_HARTS) ? (PLAT_N_IOMMU) : (PLAT_N_HARTS);
+    uint64_t base_rate = 0;
+    bool check = true;
+
+    //# Two-stage translation on all instances (DCs are shared)
+    rv_iommu_fixture(FX_TWO_STAGE);
+    for (size_t i = 1; i < n_max; i++)
+    {
+        rv_iommu_select(&rv_iommu_inst[i]);
+        set_iommu_1lvl();
+        rv_iommu_ddt_inval(false, 0);
+        rv_iommu_cq_sync();
+    }
+    rv_iommu_select(&rv_iommu_inst[0]);
+
+    for (size_t n = 1; n <= n_max; n++)
+    {
+        memset(mi_workers, 0, sizeof(mi_workers));
+        for (size_t i = 0; i < n; i++)
+            mi_workers[i].inst = &rv_iommu_inst[i];
+        __sync_synchronize();
+
+        //# Instance 0 runs on the primary hart, while the others run on the secondary harts
+        uint64_t stamp_start = CSRR(CSR_CYCLES);
+
+        for (size_t i = 1; i < n; i++)
+            hart_start(i, mi_worker, &mi_workers[i]);
+
+        mi_worker(&mi_workers[0]);
+
+        for (size_t i = 1; i < n; i++)
+            hart_join(i);
+
+        uint64_t cycles = CSRR(CSR_CYCLES) - stamp_start;
+        uint64_t ops = 0;
+        for (size_t i = 0; i < n; i++)
+        {
+            ops += mi_workers[i].ops;
+            check = (mi_workers[i].faults == 0) && check;
+        }
+
+        // Aggregate rate in milli-ops/kcycle, to compute the scaling with three decimal places
+        uint64_t rate = (ops * 1000000) / cycles;
+        if (n == 1)
+            base_rate = rate;
+
+        BENCH_REPORT_RATIO("ops/kcycle", ops * 1000, cycles, "n%lu.aggregate_rate", n);
+        BENCH_REPORT_RATIO("ops/kcycle", ops * 1000, cycles * n, "n%lu.per_instance_rate", n);
+        BENCH_REPORT_RATIO("x", rate, base_rate, "n%lu.scaling", n);
+    }
+
+    TEST_ASSERT("Multi-instance scaling: all debug translations completed without faults", check);
+
+    bench_inval_all();
+
+    TEST_END();
+}
+
+/**********************************************************************************************/
+
+// Passes over the stress pages per measurement
+#define DT_N_PASSES     (32)
+#define DT_N_XLATS      (DT_N_PASSES * N_MAPPINGS)
+
+// Debug translation flavours
+enum dt_mode {
+    DT_LEGACY_WARM,     // Per-field setters + GO + per-field response reads, IOTLB warm
+    DT_WARM,            // rv_iommu_dbg_translate(), IOTLB warm
+    DT_COLD,            // rv_iommu_dbg_translate(), IOTLB invalidated before each pass
+    DT_MODE_MAX
+};
+
+static const char* dt_mode_strs[] = {
+    [DT_LEGACY_WARM]    = "legacy.warm",
+    [DT_WARM]           = "warm",
+    [DT_COLD]           = "cold",
+};
+
+/**
+ *  Translate an IOVA with the per-field debug interface functions (one register
+ *  access per field). Returns true if the translation did not fault and matched the expected PPN
+ */
+static bool dt_legacy_translate(uint64_t device_id, uint64_t iova, uint64_t ppn)
+{
+    rv_iommu_dbg_set_iova(iova);
+    rv_iommu_dbg_set_did(device_id);
+    rv_iommu_dbg_set_pv(false);
+    rv_iommu_dbg_set_rw(true);
+    rv_iommu_dbg_set_exe(false);
+    rv_iommu_dbg_set_priv(false);
+
+    rv_iommu_dbg_set_go();
+
+    WAIT_UNTIL(rv_iommu_dbg_req_is_complete(), WAIT_BUDGET, "debug translation completion");
+
+    return (!rv_iommu_dbg_req_fault() && !rv_iommu_dbg_req_is_superpage() &&
+            (rv_iommu_dbg_translated_ppn() == ppn));
+}
+
+/**
+ *  Debug translation rate
+ *
+ *  Translate the stress pages (two-stage, 4-kiB leaves) through the debug interface DT_N_PASSES
+ *  times, with the per-field functions and with rv_iommu_dbg_translate(), IOTLB warm and cold.
+ *  Reports translations per second (cycles converted with PLAT_CPU_FREQ_HZ) and mean latency.
+ */
+bool dbg_translation_rate(){
+
+    BENCH_START();
+
+    struct rv_iommu_dbg_req req = {.device_id = DID_MIN, .rw = true};
+    struct rv_iommu_dbg_resp resp;
+    bool check = true;
+
+    rv_iommu_fixture(FX_TWO_STAGE);
+
+    for (int mode = 0; mode < DT_MODE_MAX; mode++)
+    {
+        uint64_t cycles = 0;
+        size_t mismatches = 0;
+
+        bench_inval_all();
+
+        //# Warm up the IOTLB
+        if (mode != DT_COLD)
+        {
+            for (size_t p = 0; p < N_MAPPINGS; p++)
+                bench_dbg_translate(DID_MIN, virt_page_base(STRESS_START + p));
+        }
+
+        for (size_t pass = 0; pass < DT_N_PASSES; pass++)
+        {
+            if (mode == DT_COLD)
+            {
+                rv_iommu_iotinval_vma(false, false, false, 0, 0, 0);
+                rv_iommu_iotinval_gvma(false, false, 0, 0);
+                rv_iommu_cq_sync();
+            }
+
+            uint64_t stamp_start = CSRR(CSR_CYCLES);
+
+            for (size_t p = 0; p < N_MAPPINGS; p++)
+            {
+                uint64_t iova = virt_page_base(STRESS_START + p);
+                uint64_t ppn = phys_page_base(STRESS_START + p) >> 12;
+
+                if (mode == DT_LEGACY_WARM)
+                {
+                    mismatches += !dt_legacy_translate(DID_MIN, iova, ppn);
+                }
+                else
+                {
+                    req.iova = iova;
+                    mismatches += (!rv_iommu_dbg_translate(&req, &resp) || resp.superpage || resp.ppn != ppn);
+                }
+            }
+
+            cycles += CSRR(CSR_CYCLES) - stamp_start;
+        }
+
+        check = (mismatches == 0) && check;
+
+        BENCH_REPORT("xlat/s", (DT_N_XLATS * PLAT_CPU_FREQ_HZ) / cycles, "%s.rate", dt_mode_strs[mode]);
+        BENCH_REPORT_RATIO("cycles", cycles, DT_N_XLATS, "%s.latency", dt_mode_strs[mode]);
+        BENCH_REPORT("samples", mismatches, "%s.mismatches", dt_mode_strs[mode]);
+    }
+
+    TEST_ASSERT("Debug translations: all translations completed with the expected PPN", check);
+
+    bench_inval_all();
+
+    TEST_END();
+}
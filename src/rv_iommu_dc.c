@@ -1,4 +1,10 @@
 #include <rv_iommu_dc.h>
+#include <page_tables.h>
+
+// With STATIC_TABLES, the DDT is defined in the file generated by tools/gen_tables.c
+#if (STATIC_TABLES == 0)
+ddt_t root_ddt[DDT_N_ENTRIES] __attribute__((aligned(PAGE_SIZE)));
+#endif
 
 uint64_t test_dc_tc_table[TEST_DC_MAX] = {
 
@@ -15,46 +21,50 @@ uint64_t test_dc_tc_table[TEST_DC_MAX] = {
 };
 
 /**
- *  Used to simulate multiple VMs and process address spaces 
+ *  Used to simulate multiple VMs and process address spaces (multi-tenant mode)
+ *  Device i belongs to tenant (i % N_TENANTS)
  */
-// uint64_t GSCID_ARRAY[16] = {
-//     0x0ABCULL,  // 0
-//     0x0ABDULL,  // 1
-//     0x0ABEULL,  // 2
-//     0x0ABFULL,  // 3
-//     0x0ABCULL,  // 4
-//     0x0ABDULL,  // 5
-//     0x0ABEULL,  // 6
-//     0x0ABFULL,  // 7
-//     0x0ABCULL,  // 8
-//     0x0ABDULL,  // 9
-//     0x0ABEULL,  // 10
-//     0x0ABFULL,  // 11
-//     0x0ABCULL,  // 12
-//     0x0ABDULL,  // 13
-//     0x0ABEULL,  // 14
-//     0x0ABFULL   // 15
-// };
+uint64_t TENANT_GSCID_ARRAY[16] = {
+    0x0ABCULL,  // 0
+    0x0ABDULL,  // 1
+    0x0ABEULL,  // 2
+    0x0ABFULL,  // 3
+    0x0ABCULL,  // 4
+    0x0ABDULL,  // 5
+    0x0ABEULL,  // 6
+    0x0ABFULL,  // 7
+    0x0ABCULL,  // 8
+    0x0ABDULL,  // 9
+    0x0ABEULL,  // 10
+    0x0ABFULL,  // 11
+    0x0ABCULL,  // 12
+    0x0ABDULL,  // 13
+    0x0ABEULL,  // 14
+    0x0ABFULL   // 15
+};
 
-// uint64_t PSCID_ARRAY[16] = {
-//     0x0DECULL,  // 0
-//     0x0DEDULL,  // 1
-//     0x0DEEULL,  // 2
-//     0x0DEFULL,  // 3
-//     0x0DECULL,  // 4
-//     0x0DEDULL,  // 5
-//     0x0DEEULL,  // 6
-//     0x0DEFULL,  // 7
-//     0x0DECULL,  // 8
-//     0x0DEDULL,  // 9
-//     0x0DEEULL,  // 10
-//     0x0DEFULL,  // 11
-//     0x0DECULL,  // 12
-//     0x0DEDULL,  // 13
-//     0x0DEEULL,  // 14
-//     0x0DEFULL   // 15
-// };
+uint64_t TENANT_PSCID_ARRAY[16] = {
+    0x0DECULL,  // 0
+    0x0DEDULL,  // 1
+    0x0DEEULL,  // 2
+    0x0DEFULL,  // 3
+    0x0DECULL,  // 4
+    0x0DEDULL,  // 5
+    0x0DEEULL,  // 6
+    0x0DEFULL,  // 7
+    0x0DECULL,  // 8
+    0x0DEDULL,  // 9
+    0x0DEEULL,  // 10
+    0x0DEFULL,  // 11
+    0x0DECULL,  // 12
+    0x0DEDULL,  // 13
+    0x0DEEULL,  // 14
+    0x0DEFULL   // 15
+};
 
+/**
+ *  Single address space: all devices share the same GSCID/PSCID
+ */
 uint64_t GSCID_ARRAY[16] = {
     0x0ABCULL,  // 0
     0x0ABCULL,  // 1
@@ -91,4 +101,36 @@ uint64_t PSCID_ARRAY[16] = {
     0x0DEFULL,  // 13
     0x0DEFULL,  // 14
     0x0DEFULL   // 15
-};
\ No newline at end of file
+};
+
+/**
+ *  Fill the root DDT (1LVL mode) with the basic configuration:
+ *  valid DCs for devices in [DID_MIN, DID_MAX], single-tenant GSCID/PSCID and root tables,
+ *  both translation stages in Bare mode and MSI translation off
+ */
+void ddt_init()
+{
+    // Init all entries to zero
+    for (int i = 0; i < DDT_N_ENTRIES; i++)
+    {
+        root_ddt[i].tc = 0;
+    }
+
+    // Configure DCs in the root DDT (1LVL mode)
+    for (int i = DID_MIN; i < DID_MAX + 1; i++)
+    {
+        root_ddt[i].tc = test_dc_tc_table[BASIC];
+        root_ddt[i].iohgatp = (((uintptr_t)s2pt_root) >> 12) | (IOHGATP_MODE_BARE);
+        root_ddt[i].iohgatp |= (GSCID_ARRAY[i] << GSCID_OFF);
+        root_ddt[i].ta = (PSCID_ARRAY[i] << PSCID_OFF);
+        root_ddt[i].fsc = (((uintptr_t)s1pt) >> 12) | (IOSATP_MODE_BARE);
+
+        if (MSI_TRANSLATION == 1)
+        {
+            root_ddt[i].msiptp = (((uintptr_t)msi_pt) >> 12) | (MSIPTP_MODE_OFF);
+            root_ddt[i].msi_addr_mask = MSI_ADDR_MASK;
+            root_ddt[i].msi_addr_pattern = MSI_ADDR_PATTERN;
+            root_ddt[i].reserved = 0;
+        }
+    }
+}
@@ -3,6 +3,11 @@
 #include <rv_iommu.h>
 #include <plat_dma.h>
 #include <idma.h>
+#include <bench.h>
+#include <workload.h>
+#include <wait.h>
+#include <console.h>
+#include <plic.h>
 
 /**
  * !NOTES:
@@ -95,6 +100,169 @@ bool idma_only(){
     TEST_END();
 }
 
+/**
+ *  Console transmit interrupt (UART_TX_IRQ=1).
+ *
+ *  Queue a line longer than the UART fifo and wait for the ring to drain. Writers only move one
+ *  fifo worth of bytes, so the rest must be sent by the THRE interrupt handler, taken within
+ *  interrupt windows. Runs after reset_state(), so it also checks that mie.MEIE survives it
+ */
+bool uart_tx_irq(){
+
+    TEST_START();
+
+    if (UART_TX_IRQ)
+    {
+        uint64_t irqs = console_tx_irqs();
+
+        printf("\nuart_tx_irq: this line is longer than the transmit fifo of the UART\n");
+        LOG_FLUSH();
+
+        WAIT_UNTIL((plic_irq_window(), console_tx_pending() == 0), WAIT_BUDGET, "console TX ring drained");
+
+        TEST_ASSERT("Console TX ring drained by the THRE interrupt", console_tx_irqs() > irqs);
+    }
+    else
+    {
+        VERBOSE("UART_TX_IRQ=0: skipping");
+    }
+
+    TEST_END();
+}
+
+// Buffers of the string function test: lengths up to 256 bytes at offsets up to 15, plus a guard
+#define MEMF_BUF_SIZE   (256 + 32)
+#define MEMF_GUARD      (0xEE)
+
+static uint8_t memf_a[MEMF_BUF_SIZE] __attribute__((aligned(8)));
+static uint8_t memf_b[MEMF_BUF_SIZE] __attribute__((aligned(8)));
+
+// Lengths around the word-copy threshold (32 bytes) and the unrolled loops (64 bytes)
+static const size_t memf_lens[] = {0, 1, 7, 8, 9, 31, 32, 33, 63, 64, 65, 100, 256};
+#define MEMF_N_LENS     (sizeof(memf_lens)/sizeof(memf_lens[0]))
+
+// Buffer offsets of memcmp: same alignment (word compare) and different alignment (byte compare)
+static const size_t memf_cmp_offs[][2] = {{0, 0}, {3, 3}, {5, 13}, {3, 5}, {0, 7}};
+#define MEMF_N_CMP_OFFS (sizeof(memf_cmp_offs)/sizeof(memf_cmp_offs[0]))
+
+static inline uint8_t memf_pattern(size_t i)
+{
+    return (uint8_t)((i * 131) + 7);
+}
+
+// Fill a buffer through a volatile pointer, so the compiler does not turn the loop into a memset call
+static void memf_fill(uint8_t *buf, bool pattern)
+{
+    volatile uint8_t *v = buf;
+
+    for (size_t i = 0; i < MEMF_BUF_SIZE; i++)
+        v[i] = (pattern) ? (memf_pattern(i)) : (MEMF_GUARD);
+}
+
+static inline int memf_sign(int x)
+{
+    return (x > 0) - (x < 0);
+}
+
+/**
+ *  String functions of the platform (memcpy, memset, memcmp).
+ *
+ *  Checks memcpy and memset with all source/destination offsets within a word and lengths around
+ *  the word-access thresholds, including the bytes around the destination, and the sign of memcmp
+ *  with a difference in the first, middle and last word, with aligned and misaligned buffers
+ */
+bool mem_functions(){
+
+    TEST_START();
+
+    volatile uint8_t *a = memf_a;
+    volatile uint8_t *b = memf_b;
+
+    //# memcpy: misaligned source and destination
+    size_t cpy_errors = 0;
+    for (size_t s_off = 0; s_off < 16; s_off++)
+    {
+        for (size_t d_off = 0; d_off < 16; d_off++)
+        {
+            for (size_t l = 0; l < MEMF_N_LENS; l++)
+            {
+                size_t len = memf_lens[l];
+
+                memf_fill(memf_a, true);
+                memf_fill(memf_b, false);
+                memcpy(&memf_b[d_off], &memf_a[s_off], len);
+
+                for (size_t i = 0; i < MEMF_BUF_SIZE; i++)
+                {
+                    bool in = (i >= d_off) && (i < d_off + len);
+                    uint8_t exp = (in) ? (memf_pattern(s_off + i - d_off)) : (MEMF_GUARD);
+                    cpy_errors += (b[i] != exp);
+                }
+            }
+        }
+    }
+    TEST_ASSERT("memcpy: misaligned source/destination and lengths around 32 bytes", cpy_errors == 0);
+
+    //# memset: misaligned destination
+    size_t set_errors = 0;
+    for (size_t d_off = 0; d_off < 16; d_off++)
+    {
+        for (size_t l = 0; l < MEMF_N_LENS; l++)
+        {
+            size_t len = memf_lens[l];
+
+            memf_fill(memf_b, false);
+            memset(&memf_b[d_off], 0x5A, len);
+
+            for (size_t i = 0; i < MEMF_BUF_SIZE; i++)
+            {
+                bool in = (i >= d_off) && (i < d_off + len);
+                set_errors += (b[i] != ((in) ? (0x5A) : (MEMF_GUARD)));
+            }
+        }
+    }
+    TEST_ASSERT("memset: misaligned destination and lengths around 32 bytes", set_errors == 0);
+
+    //# memcmp: equal buffers, and a difference in the first, middle and last word
+    size_t cmp_errors = 0;
+    for (size_t o = 0; o < MEMF_N_CMP_OFFS; o++)
+    {
+        size_t a_off = memf_cmp_offs[o][0];
+        size_t b_off = memf_cmp_offs[o][1];
+
+        for (size_t l = 0; l < MEMF_N_LENS; l++)
+        {
+            size_t len = memf_lens[l];
+
+            memf_fill(memf_a, true);
+            for (size_t i = 0; i < len; i++)
+                b[b_off + i] = a[a_off + i];
+
+            cmp_errors += (memcmp(&memf_a[a_off], &memf_b[b_off], len) != 0);
+
+            if (len == 0)
+                continue;
+
+            size_t pos[] = {0, len / 2, len - 1};
+            for (size_t p = 0; p < 3; p++)
+            {
+                // Flip the MSB, so the sign also checks that bytes are compared as unsigned
+                uint8_t orig = b[b_off + pos[p]];
+                uint8_t diff = orig ^ 0x80;
+                int exp = (diff > orig) ? (1) : (-1);
+
+                b[b_off + pos[p]] = diff;
+                cmp_errors += (memf_sign(memcmp(&memf_b[b_off], &memf_a[a_off], len)) != exp);
+                cmp_errors += (memf_sign(memcmp(&memf_a[a_off], &memf_b[b_off], len)) != -exp);
+                b[b_off + pos[p]] = orig;
+            }
+        }
+    }
+    TEST_ASSERT("memcmp: sign of the first difference, aligned and misaligned buffers", cmp_errors == 0);
+
+    TEST_END();
+}
+
 /**
  *  Test multi-beat transfers in the SoC with iDMA module directly connected 
  *  to the XBAR, i.e., without IOMMU.
@@ -184,8 +352,7 @@ bool iommu_off(){
     TEST_START();
 
     //# Set IOMMU off
-    fence_i();
-    set_iommu_off();
+    rv_iommu_fixture(FX_OFF);
     VERBOSE("IOMMU Off");
 
     /** Instantiate and map the DMA device */
@@ -237,8 +404,7 @@ bool iommu_bare(){
     TEST_START();
 
     //# Set IOMMU to Bare
-    fence_i();
-    set_iommu_bare();
+    rv_iommu_fixture(FX_BARE);
     VERBOSE("IOMMU in Bare mode");
 
     /** Map the DMA device */
@@ -284,10 +450,7 @@ bool both_stages_bare(){
     size_t idma_idx = 0;
     struct idma *dma_ut = (void*)idma_addr[idma_idx];
 
-    fence_i();
-    set_iommu_1lvl();
-    rv_iommu_set_iosatp_bare();
-    rv_iommu_set_iohgatp_bare();
+    rv_iommu_fixture(FX_STAGES_BARE);
     VERBOSE("IOMMU 1LVL mode | iohgatp: Bare | iosatp: Bare");
 
     //# Get addresses
@@ -339,11 +502,7 @@ bool second_stage_only(){
     size_t idma_idx = 0;
     struct idma *dma_ut = (void*)idma_addr[idma_idx];
 
-    fence_i();
-    set_iommu_1lvl();
-    rv_iommu_set_iosatp_bare();
-    rv_iommu_set_iohgatp_sv39x4();
-    rv_iommu_set_msi_flat();
+    rv_iommu_fixture(FX_S2_ONLY_MSI);
     VERBOSE("IOMMU 1LVL mode | iohgatp: Sv39x4 | iosatp: Bare | msiptp: Flat");
 
     //# DDTC Invalidation
@@ -407,11 +566,7 @@ bool two_stage_translation(){
     size_t idma_idx = 0;
     struct idma *dma_ut = (void*)idma_addr[idma_idx];
     
-    fence_i();
-    set_iommu_1lvl();
-    rv_iommu_set_iosatp_sv39();
-    rv_iommu_set_iohgatp_sv39x4();
-    rv_iommu_set_msi_flat();
+    rv_iommu_fixture(FX_TWO_STAGE_MSI);
     VERBOSE("IOMMU 1LVL mode | iohgatp: Sv39x4 | iosatp: Sv39 | msiptp: Flat");
 
     //# DDTC Invalidation
@@ -512,11 +667,7 @@ bool iotinval(){
     size_t idma_idx = 0;
     struct idma *dma_ut = (void*)idma_addr[idma_idx];
 
-    fence_i();
-    set_iommu_1lvl();
-    rv_iommu_set_iosatp_sv39();
-    rv_iommu_set_iohgatp_sv39x4();
-    rv_iommu_set_msi_flat();
+    rv_iommu_fixture(FX_TWO_STAGE_MSI);
     VERBOSE("IOMMU 1LVL mode | iohgatp: Sv39x4 | iosatp: Sv39 | msiptp: Flat");
 
     //# Get a set of Guest-Virtual-to-Supervisor-Physical mappings
@@ -615,11 +766,7 @@ bool wsi_generation(){
     size_t idma_idx = 0;
     struct idma *dma_ut = (void*)idma_addr[idma_idx];
 
-    fence_i();
-    set_iommu_1lvl();
-    rv_iommu_set_iosatp_sv39();
-    rv_iommu_set_iohgatp_sv39x4();
-    rv_iommu_set_msi_flat();
+    rv_iommu_fixture(FX_TWO_STAGE_MSI);
     VERBOSE("IOMMU 1LVL mode | iohgatp: Sv39x4 | iosatp: Sv39 | msiptp: Flat");
 
     //# Configure the IOMMU to generate interrupts as WSI
@@ -735,11 +882,7 @@ bool msi_generation(){
     size_t idma_idx = 0;
     struct idma *dma_ut = (void*)idma_addr[idma_idx];
     
-    fence_i();
-    set_iommu_1lvl();
-    rv_iommu_set_iosatp_sv39();
-    rv_iommu_set_iohgatp_sv39x4();
-    rv_iommu_set_msi_flat();
+    rv_iommu_fixture(FX_TWO_STAGE_MSI);
     VERBOSE("IOMMU 1LVL mode | iohgatp: Sv39x4 | iosatp: Sv39 | msiptp: Flat");
     VERBOSE("CQ interrupt vector masked");
 
@@ -816,11 +959,7 @@ bool hpm(){
     size_t idma_idx = 0;
     struct idma *dma_ut = (void*)idma_addr[idma_idx];
 
-    fence_i();
-    set_iommu_1lvl();
-    rv_iommu_set_iosatp_sv39();
-    rv_iommu_set_iohgatp_sv39x4();
-    rv_iommu_set_msi_flat();
+    rv_iommu_fixture(FX_TWO_STAGE_MSI);
     VERBOSE("IOMMU 1LVL mode | iohgatp: Sv39x4 | iosatp: Sv39 | msiptp: Flat");
 
     // Flush cache
@@ -847,12 +986,8 @@ bool hpm(){
     rv_iommu_set_iocountihn(iocountinh);
 
     // Monitor CY bit of iohpmcycles, wait for it to go high
-    do
-    {
-        iohpmcycles = rv_iommu_get_iohpmcycles();
-        printf("iohpmcycles value: %llx\n", iohpmcycles);
-    }
-    while (!(iohpmcycles & (0x1ULL << 63)));
+    WAIT_UNTIL((iohpmcycles = rv_iommu_get_iohpmcycles()) & (0x1ULL << 63), WAIT_BUDGET, "iohpmcycles overflow");
+    VERBOSE("iohpmcycles value: %llx", iohpmcycles);
     
     // Check iocountovf bit
     uint32_t iocountovf = rv_iommu_get_iocountovf();
@@ -884,15 +1019,8 @@ bool hpm(){
     rv_iommu_set_iocountihn(iocountinh);
 
     // Monitor CY bit of iohpmcycles, wait for it to go high
-    do
-    {
-        iohpmcycles = rv_iommu_get_iohpmcycles();
-        printf("iohpmcycles value: %llx\n", iohpmcycles);
-        for (size_t i = 0; i < 10000; i++)
-            ;
-    }
-    // while ((iohpmcycles & (0x1ULL << 62)));
-    while (!(iohpmcycles & (0x1ULL << 63)));
+    WAIT_UNTIL((iohpmcycles = rv_iommu_get_iohpmcycles()) & (0x1ULL << 63), WAIT_BUDGET, "iohpmcycles overflow");
+    VERBOSE("iohpmcycles value: %llx", iohpmcycles);
     
     // Check iocountovf bit
     iocountovf = rv_iommu_get_iocountovf();
@@ -989,11 +1117,7 @@ bool mrif_support(){
 
     //# TEST 1: MRIF transaction with second-stage only and MSI notice write
     // Configure data structures and IOMMU
-    fence_i();
-    set_iommu_1lvl();
-    rv_iommu_set_iosatp_bare();
-    rv_iommu_set_iohgatp_sv39x4();
-    rv_iommu_set_msi_flat();
+    rv_iommu_fixture(FX_S2_ONLY_MSI);
     VERBOSE("IOMMU 1LVL mode | iohgatp: Sv39x4 | iosatp: Bare | msiptp: Flat");
 
     // DDTC Invalidation
@@ -1134,11 +1258,7 @@ bool dbg_interface(){
     size_t idma_idx = 0;
     struct idma *dma_ut = (void*)idma_addr[idma_idx];
 
-    fence_i();
-    set_iommu_1lvl();
-    rv_iommu_set_iosatp_sv39();
-    rv_iommu_set_iohgatp_sv39x4();
-    rv_iommu_set_msi_flat();
+    rv_iommu_fixture(FX_TWO_STAGE_MSI);
     VERBOSE("IOMMU 1LVL mode | iohgatp: Sv39x4 | iosatp: Sv39 | msiptp: Flat");
 
     // Get virtual addresses
@@ -1164,8 +1284,7 @@ bool dbg_interface(){
     rv_iommu_dbg_set_go();
 
     // Wait for the transaction to be completed
-    while (!rv_iommu_dbg_req_is_complete())
-        ;
+    WAIT_UNTIL(rv_iommu_dbg_req_is_complete(), WAIT_BUDGET, "debug translation completion");
     
     // Check response register
     bool check = (!rv_iommu_dbg_req_fault() && !rv_iommu_dbg_req_is_superpage() &&
@@ -1182,8 +1301,7 @@ bool dbg_interface(){
     rv_iommu_dbg_set_go();
 
     // Wait for the transaction to be completed
-    while (!rv_iommu_dbg_req_is_complete())
-        ;
+    WAIT_UNTIL(rv_iommu_dbg_req_is_complete(), WAIT_BUDGET, "debug translation completion");
     
     // Check response register
     check = (!rv_iommu_dbg_req_fault() && rv_iommu_dbg_req_is_superpage() &&
@@ -1203,8 +1321,7 @@ bool dbg_interface(){
     rv_iommu_dbg_set_go();
 
     // Wait for the transaction to be completed
-    while (!rv_iommu_dbg_req_is_complete())
-        ;
+    WAIT_UNTIL(rv_iommu_dbg_req_is_complete(), WAIT_BUDGET, "debug translation completion");
     
     // Check response register
     check = (!rv_iommu_dbg_req_fault() && rv_iommu_dbg_req_is_superpage() &&
@@ -1223,8 +1340,7 @@ bool dbg_interface(){
     rv_iommu_dbg_set_go();
 
     // Wait for the transaction to be completed
-    while (!rv_iommu_dbg_req_is_complete())
-        ;
+    WAIT_UNTIL(rv_iommu_dbg_req_is_complete(), WAIT_BUDGET, "debug translation completion");
     
     // Check response register
     check = (rv_iommu_dbg_req_fault());
@@ -1245,46 +1361,55 @@ bool dbg_interface(){
 }
 
 /**
- *  Test to calculate latency using different number of PTs and devices
+ *  Test to calculate latency using different number of PTs and devices.
+ *  Each sample is recorded in a log-bucketed histogram and tagged as hit or miss
+ *  depending on whether the IOTLB miss counter advanced during the transfer
  */
 bool latency_test(){
 
-    TEST_START();
-
-    /** Instantiate and map the DMA device */
-    size_t idma_idx = 0;
-    struct idma *dma_ut = (void*)idma_addr[idma_idx];
+    BENCH_START();
 
     uint64_t stamp_start = 0;
     uint64_t stamp_end = 0;
-    uint64_t avg_lat = 0;
-    uint64_t stamp = 0;
 
-    fence_i();
-    set_iommu_1lvl();
-    rv_iommu_set_iosatp_sv39();
-    rv_iommu_set_iohgatp_sv39x4();
+    static struct bench_hist lat_all, lat_hit, lat_miss;
+    bench_hist_reset(&lat_all);
+    bench_hist_reset(&lat_hit);
+    bench_hist_reset(&lat_miss);
 
-    rv_iommu_ddt_inval(false, idma_ids[idma_idx]);
+    rv_iommu_fixture(FX_TWO_STAGE);
+
+    rv_iommu_ddt_inval(false, 0);
     rv_iommu_iotinval_vma(false, false, false, 0, 0, 0);
     rv_iommu_iotinval_gvma(false, false, 0, 0);
 
-    rv_iommu_set_iohpmctr(0, 0);
-    rv_iommu_set_iohpmctr(0, 1);
-    rv_iommu_set_iohpmctr(0, 2);
-    rv_iommu_set_iohpmctr(0, 3);
-    rv_iommu_set_iohpmctr(0, 5);
-
-    stamp = CSRR(CSR_CYCLES);
-    srand(stamp);
+    rv_iommu_set_iohpmctr(0, HPM_CTR_UT_REQ);
+    rv_iommu_set_iohpmctr(0, HPM_CTR_IOTLB_MISS);
+    rv_iommu_set_iohpmctr(0, HPM_CTR_DDTW);
+    rv_iommu_set_iohpmctr(0, HPM_CTR_S1_PTW);
+    rv_iommu_set_iohpmctr(0, HPM_CTR_S2_PTW);
+
+    //# Uniform random accesses over the stress pages, from all DMA devices.
+    // The PRNG is seeded with WL_SEED, so runs are reproducible
+    struct workload_cfg cfg = {
+        .pattern    = WL_UNIFORM,
+        .n_pages    = N_MAPPINGS,
+        .n_devices  = N_DMA,
+        .seed       = WL_SEED,
+    };
+    static struct workload wl;
+    workload_init(&wl, &cfg);
 
     for (size_t i = 0; i < N_TRANSFERS; i++)
     {
+        struct wl_access acc;
+        workload_next(&wl, &acc);
+
         /** Instantiate and map the DMA device */
-        size_t idma_idx = rand() % N_DMA;
+        size_t idma_idx = acc.device;
         struct idma *dma_ut = (void*)idma_addr[idma_idx];
 
-        size_t pt_index = rand() % N_MAPPINGS;
+        size_t pt_index = acc.page;
 
         //# Get a set of Guest-Virtual-to-Supervisor-Physical mappings
         uintptr_t read_paddr = phys_page_base(pt_index + STRESS_START);
@@ -1301,36 +1426,44 @@ bool latency_test(){
         
         idma_setup(dma_ut, (uint64_t)read_vaddr, (uint64_t)write_vaddr, 8);
 
+        uint64_t iotlb_miss = rv_iommu_get_iohpmctr(HPM_CTR_IOTLB_MISS);
+
         // Start stamp
         stamp_start = CSRR(CSR_CYCLES);
 
         // Check if iDMA was set up properly and init transfer
-        uint64_t trans_id = read64((uintptr_t)&dma_ut->next_transfer_id);
+        uint64_t trans_id = idma_submit(dma_ut);
         if (!trans_id)
             {ERROR("iDMA misconfigured")}
 
         // Poll transfer status
-        while (read64((uintptr_t)&dma_ut->last_transfer_id_complete) != trans_id)
-            ;
+        idma_wait(dma_ut, trans_id);
 
         // End stamp
         stamp_end = CSRR(CSR_CYCLES);
 
+        //# Record sample, tagged by the IOTLB miss counter
+        bench_hist_add(&lat_all, stamp_end - stamp_start);
+        if (rv_iommu_get_iohpmctr(HPM_CTR_IOTLB_MISS) != iotlb_miss)
+            bench_hist_add(&lat_miss, stamp_end - stamp_start);
+        else
+            bench_hist_add(&lat_hit, stamp_end - stamp_start);
+
         fence_i();
 
         if (read64(write_paddr) != 0xDEADBEEF)
             {ERROR("Transfer does not match")}
-
-        avg_lat += (stamp_end - stamp_start);
     }
 
-    printf("Transfer average latency (in cycles): %llu\n", avg_lat/N_TRANSFERS);
+    BENCH_REPORT_HIST("cycles", &lat_all, "latency.all");
+    BENCH_REPORT_HIST("cycles", &lat_hit, "latency.iotlb_hit");
+    BENCH_REPORT_HIST("cycles", &lat_miss, "latency.iotlb_miss");
 
-    printf("Untranslated Requests cnt: %llu\n", rv_iommu_get_iohpmctr(0));
-    printf("IOTLB miss cnt: %llu\n",            rv_iommu_get_iohpmctr(1));
-    printf("DDT Walks cnt: %llu\n",             rv_iommu_get_iohpmctr(2));
-    printf("First-stage PT walk cnt: %llu\n",   rv_iommu_get_iohpmctr(3));
-    printf("Second-stage PT walk cnt: %llu\n",  rv_iommu_get_iohpmctr(4));
+    BENCH_REPORT("events", rv_iommu_get_iohpmctr(HPM_CTR_UT_REQ),     "untranslated_requests");
+    BENCH_REPORT("events", rv_iommu_get_iohpmctr(HPM_CTR_IOTLB_MISS), "iotlb_misses");
+    BENCH_REPORT("events", rv_iommu_get_iohpmctr(HPM_CTR_DDTW),       "ddt_walks");
+    BENCH_REPORT("events", rv_iommu_get_iohpmctr(HPM_CTR_S1_PTW),     "s1_pt_walks");
+    BENCH_REPORT("events", rv_iommu_get_iohpmctr(HPM_CTR_S2_PTW),     "s2_pt_walks");
 
     TEST_END();
 }
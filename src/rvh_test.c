@@ -1,4 +1,5 @@
 #include <rvh_test.h>
+#include <plic.h>
 
 // count the total number of tests perfomed in a single run
 uint32_t num_total_tests;
@@ -9,8 +10,9 @@ uint32_t num_succ_tests;
 
 // Test functions are manually assigned to the .test_table section
 // The test_table_size is calculated based on the start and the end of the section
-extern test_func_t _test_table, _test_table_size;
-test_func_t* test_table = &_test_table;
+extern const struct test_desc* _test_table;
+extern test_func_t _test_table_size;
+const struct test_desc** test_table = &_test_table;
 size_t test_table_size = (size_t) &_test_table_size;
 
 unsigned test_num = 0;
@@ -208,12 +210,39 @@ static inline uint64_t next_instruction(uint64_t epc){
     return from_priv;\
 }
 
+// Machine-level interrupt handlers, indexed by interrupt cause (without the interrupt bit)
+#define M_IRQ_N_CAUSES  (16)
+static irq_handler_t m_irq_handlers[M_IRQ_N_CAUSES];
+
+/**
+ *  Register a handler for a machine-level interrupt cause (e.g., CAUSE_MEI).
+ *  Registered interrupts are serviced by mhandler and are not reported as exceptions.
+ *  A NULL handler unregisters the cause
+ */
+void set_m_irq_handler(uint64_t cause, irq_handler_t handler){
+    if(!(cause & CAUSE_INT_BIT) || (cause & CAUSE_MSK) >= M_IRQ_N_CAUSES){
+        ERROR("invalid interrupt cause");
+    }
+    m_irq_handlers[cause & CAUSE_MSK] = handler;
+}
+
 uint64_t mhandler(){
 
     real_priv = PRIV_M;
 
     uint64_t cause = CSRR(mcause);
     uint64_t epc = CSRR(mepc);
+
+    // Registered interrupts do not update the exception status. They are dispatched before
+    // any logging, so handlers never re-enter stdio or queue console output
+    if((cause & CAUSE_INT_BIT) && ((cause & CAUSE_MSK) < M_IRQ_N_CAUSES) &&
+        (m_irq_handlers[cause & CAUSE_MSK] != NULL)){
+        m_irq_handlers[cause & CAUSE_MSK]();
+        unsigned temp_priv = real_priv;
+        real_priv = curr_priv;
+        return_from_exception(temp_priv, curr_priv, cause, epc);
+    }
+
     uint64_t tval = CSRR(mtval);
     uint64_t tval2 = CSRR(CSR_MTVAL2);
     uint64_t tinst= CSRR(CSR_MTINST);
@@ -359,6 +388,109 @@ uint64_t vshandler(){
     return_from_exception(temp_priv, curr_priv, cause, epc);
 }
 
+/**
+ *  True if the token of length len matches one of the comma-separated items of list
+ */
+static bool test_token_match(const char *list, const char *token, size_t len)
+{
+    while (*list != '\0')
+    {
+        size_t item_len = strcspn(list, ",");
+
+        if (item_len == len && strncmp(list, token, len) == 0)
+            return true;
+
+        list += item_len;
+        list += (*list == ',');
+    }
+
+    return false;
+}
+
+/**
+ *  True if a test is selected by a comma-separated list of names and tags.
+ *  Tokens prefixed with '-' exclude the test, and take precedence over the others
+ */
+bool test_selected(const struct test_desc *test, const char *sel)
+{
+    bool selected = false;
+
+    while (*sel != '\0')
+    {
+        bool exclude = (*sel == '-');
+        sel += exclude;
+
+        size_t len = strcspn(sel, ",");
+        bool match = (strlen(test->name) == len && strncmp(test->name, sel, len) == 0) ||
+                        test_token_match(test->tags, sel, len);
+
+        if (match && exclude)
+            return false;
+        selected = selected || match;
+
+        sel += len;
+        sel += (*sel == ',');
+    }
+
+    return selected;
+}
+
+/**
+ *  Print a string field of a structured record, escaping quotes according to the output format
+ */
+static void output_field(const char *str)
+{
+    putchar('"');
+    for (; *str != '\0'; str++)
+    {
+        if (*str == '"')
+            putchar((OUTPUT_FMT == OUTPUT_CSV) ? ('"') : ('\\'));
+        else if (*str == '\\' && OUTPUT_FMT == OUTPUT_JSON)
+            putchar('\\');
+        putchar(*str);
+    }
+    putchar('"');
+}
+
+/**
+ *  Print a test or benchmark result as a CSV or JSON-lines record.
+ *  The value must be a numeric string. The CSV header is printed before the first record
+ */
+void output_record(const char *type, const char *test, const char *name, const char *value, const char *unit)
+{
+    static bool header = false;
+
+    if (OUTPUT_FMT == OUTPUT_CSV)
+    {
+        if (!header)
+            printf("\ntype,test,name,value,unit\n");
+        header = true;
+
+        printf("%s,%s,", type, test);
+        output_field(name);
+        printf(",%s,%s\n", value, unit);
+    }
+    else if (OUTPUT_FMT == OUTPUT_JSON)
+    {
+        printf("{\"type\":\"%s\",\"test\":\"%s\",\"name\":", type, test);
+        output_field(name);
+        printf(",\"value\":%s,\"unit\":\"%s\"}\n", value, unit);
+    }
+}
+
+/**
+ *  Print the number of passed and total assertions as structured records
+ */
+void output_summary(uint32_t succ, uint32_t total)
+{
+    char value[16];
+
+    snprintf(value, sizeof(value), "%u", succ);
+    output_record("summary", "", "passed", value, "asserts");
+    snprintf(value, sizeof(value), "%u", total);
+    output_record("summary", "", "total", value, "asserts");
+}
+
 extern void hshandler_entry();
 extern void mhandler_entry();
 extern void vshandler_entry();
@@ -419,6 +551,9 @@ void reset_state(){
 
     CSRW(CSR_VSTVEC, vshandler_entry);
 
+    // Interrupt sources registered with the PLIC (UART, iDMA) stay enabled
+    plic_irq_rearm();
+
     sfence();
     hfence();
 }
@@ -1,27 +1,46 @@
 #include <rvh_test.h> // necessary to use TEST_REGISTER macro
 
 /**
- *  List of tests.
- *  To disable a test from the application, comment the corresponding line
+ *  List of tests and their tags.
+ *  Tests are selected by name or tag with the TESTS make variable (default: arch),
+ *  or at boot through fromhost
  */
 
+// IOMMU benchmarks
+TEST_REGISTER(tenant_inval_cost, "bench");
+TEST_REGISTER(dma_traffic_scaling, "bench");
+TEST_REGISTER(dma_pipelined_throughput, "bench");
+TEST_REGISTER(dma_bandwidth_sweep, "bench");
+TEST_REGISTER(dma_completion_modes, "bench");
+TEST_REGISTER(dma_sg_bandwidth, "bench");
+TEST_REGISTER(translation_workloads, "bench");
+TEST_REGISTER(cache_tier_latency, "bench");
+TEST_REGISTER(translation_matrix, "bench");
+TEST_REGISTER(concurrent_driver_load, "bench,smp");
+TEST_REGISTER(multi_iommu_scaling, "bench,smp");
+TEST_REGISTER(dbg_translation_rate, "bench");
+
 // IOMMU latency test
-// TEST_REGISTER(latency_test);
+TEST_REGISTER(latency_test, "latency");
 
 // IOMMU Arch tests
-TEST_REGISTER(dbg_interface);
-TEST_REGISTER(mrif_support);
-TEST_REGISTER(hpm);
-TEST_REGISTER(msi_generation);
-TEST_REGISTER(iofence);
-TEST_REGISTER(wsi_generation);
-TEST_REGISTER(iotinval);
-TEST_REGISTER(two_stage_translation);
-TEST_REGISTER(second_stage_only);
-TEST_REGISTER(both_stages_bare);
-TEST_REGISTER(iommu_bare);
-TEST_REGISTER(iommu_off);
+TEST_REGISTER(dbg_interface, "arch,dbg");
+TEST_REGISTER(mrif_support, "arch,msi");
+TEST_REGISTER(hpm, "arch,hpm");
+TEST_REGISTER(msi_generation, "arch,irq");
+TEST_REGISTER(iofence, "arch,cq");
+TEST_REGISTER(wsi_generation, "arch,irq");
+TEST_REGISTER(iotinval, "arch,cq,translation");
+TEST_REGISTER(two_stage_translation, "arch,translation");
+TEST_REGISTER(second_stage_only, "arch,translation,msi");
+TEST_REGISTER(both_stages_bare, "arch,translation");
+TEST_REGISTER(iommu_bare, "arch,translation");
+TEST_REGISTER(iommu_off, "arch,fault");
 
 // iDMA-only tests
-// TEST_REGISTER(idma_only_multiple_beats);
-// TEST_REGISTER(idma_only);
+TEST_REGISTER(idma_only_multiple_beats, "idma");
+TEST_REGISTER(idma_only, "idma");
+
+// Platform tests
+TEST_REGISTER(uart_tx_irq, "platform");
+TEST_REGISTER(mem_functions, "platform");
@@ -0,0 +1,50 @@
+#include <wait.h>
+#include <rv_iommu.h>
+
+// Wait sites are manually assigned to the .wait_sites section by the WAIT_UNTIL macro
+extern struct wait_site _wait_sites, _wait_sites_end;
+
+/**
+ *  Record the time-to-condition of a wait. Site records are shared by all harts, so they are
+ *  updated atomically
+ */
+void wait_record(struct wait_site *site, uint64_t cycles)
+{
+    __atomic_fetch_add(&site->count, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&site->sum, cycles, __ATOMIC_RELAXED);
+
+    uint64_t max = __atomic_load_n(&site->max, __ATOMIC_RELAXED);
+    while (cycles > max &&
+           !__atomic_compare_exchange_n(&site->max, &max, cycles, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+        ;
+}
+
+/**
+ *  Print the IOMMU state and abort the execution upon a wait timeout
+ */
+void wait_timeout(struct wait_site *site, uint64_t cycles)
+{
+    printf("\nWAIT TIMEOUT: %s (%s:%u) not met after %llu cycles\n", site->what, site->func, site->line, cycles);
+    rv_iommu_dump_state();
+
+    ERROR("wait timeout");
+}
+
+/**
+ *  Print the number of waits, average and maximum time-to-condition of each wait site
+ */
+void wait_report(void)
+{
+    if (LOG_LEVEL < LOG_DETAIL)
+        return;
+
+    printf("\nWait sites (count / avg / max cycles):\n");
+    for (struct wait_site *site = &_wait_sites; site < &_wait_sites_end; site++)
+    {
+        if (site->count == 0)
+            continue;
+
+        printf("\t%-40s %-32s %8llu %10llu %10llu\n", site->what, site->func, site->count,
+                site->sum / site->count, site->max);
+    }
+}
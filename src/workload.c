@@ -0,0 +1,165 @@
+#include <workload.h>
+
+const char* wl_pattern_strs[] = {
+    [WL_SEQUENTIAL]     = "sequential",
+    [WL_STRIDED]        = "strided",
+    [WL_UNIFORM]        = "uniform",
+    [WL_ZIPF]           = "zipf",
+    [WL_PHASED]         = "phased",
+};
+
+// Zipf CDF (fixed-point) and rank-to-page permutation, built by workload_init()
+// A single Zipf workload can be active at a time
+static uint32_t zipf_cdf[WL_MAX_PAGES];
+static uint16_t zipf_perm[WL_MAX_PAGES];
+
+// Scale of the Zipf weights. The weight of rank k is WL_ZIPF_SCALE / k^s
+#define WL_ZIPF_SCALE   (1ULL << 20)
+
+/**
+ *  xorshift64* PRNG. Returns the next pseudo-random number and updates the state
+ */
+uint64_t wl_rand(uint64_t *state)
+{
+    uint64_t x = *state;
+
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    *state = x;
+
+    return (x * 0x2545F4914F6CDD1DULL);
+}
+
+/**
+ *  Returns the smallest index whose cumulative weight is greater than r
+ */
+static size_t wl_cdf_search(const uint32_t *cdf, size_t n, uint64_t r)
+{
+    size_t lo = 0, hi = n - 1;
+
+    while (lo < hi)
+    {
+        size_t mid = (lo + hi) / 2;
+        if (cdf[mid] > r)
+            hi = mid;
+        else
+            lo = mid + 1;
+    }
+
+    return lo;
+}
+
+/**
+ *  Build the Zipf CDF over n_pages ranks, and a random permutation
+ *  so that hot ranks are not mapped to contiguous pages
+ */
+static void wl_zipf_init(struct workload *wl)
+{
+    uint64_t acc = 0;
+
+    for (size_t k = 0; k < wl->cfg.n_pages; k++)
+    {
+        uint64_t div = 1;
+        for (unsigned e = 0; e < wl->cfg.zipf_s; e++)
+            div *= (k + 1);
+
+        uint64_t w = WL_ZIPF_SCALE / div;
+        acc += (w != 0) ? (w) : (1);
+        zipf_cdf[k] = acc;
+        zipf_perm[k] = k;
+    }
+
+    // Fisher-Yates shuffle
+    for (size_t k = wl->cfg.n_pages - 1; k > 0; k--)
+    {
+        size_t j = wl_rand(&wl->rng) % (k + 1);
+        uint16_t tmp = zipf_perm[k];
+        zipf_perm[k] = zipf_perm[j];
+        zipf_perm[j] = tmp;
+    }
+}
+
+/**
+ *  Initialize a workload. Working set sizes and number of devices are clamped to the supported range
+ */
+void workload_init(struct workload *wl, const struct workload_cfg *cfg)
+{
+    wl->cfg = *cfg;
+    wl->rng = (cfg->seed != 0) ? (cfg->seed) : (WL_SEED);
+    wl->n_access = 0;
+    wl->phase_base = 0;
+
+    if (wl->cfg.n_pages == 0 || wl->cfg.n_pages > WL_MAX_PAGES)
+        wl->cfg.n_pages = WL_MAX_PAGES;
+
+    if (wl->cfg.n_devices == 0 || wl->cfg.n_devices > WL_MAX_DEVICES)
+        wl->cfg.n_devices = 1;
+
+    if (wl->cfg.stride == 0)
+        wl->cfg.stride = 1;
+
+    if (wl->cfg.zipf_s == 0)
+        wl->cfg.zipf_s = 1;
+
+    if (wl->cfg.phase_len == 0)
+        wl->cfg.phase_len = wl->cfg.n_pages;
+
+    if (wl->cfg.phase_pages == 0 || wl->cfg.phase_pages > wl->cfg.n_pages)
+        wl->cfg.phase_pages = wl->cfg.n_pages;
+
+    //# Device mix
+    uint32_t acc = 0;
+    for (size_t d = 0; d < wl->cfg.n_devices; d++)
+    {
+        acc += (wl->cfg.device_weights != NULL) ? (wl->cfg.device_weights[d]) : (1);
+        wl->dev_cdf[d] = acc;
+    }
+
+    if (wl->cfg.pattern == WL_ZIPF)
+        wl_zipf_init(wl);
+}
+
+/**
+ *  Generate the next access of a workload
+ */
+void workload_next(struct workload *wl, struct wl_access *acc)
+{
+    size_t n_pages = wl->cfg.n_pages;
+    uint64_t i = wl->n_access++;
+
+    //# Device
+    if (wl->cfg.n_devices == 1)
+        acc->device = 0;
+    else
+        acc->device = wl_cdf_search(wl->dev_cdf, wl->cfg.n_devices,
+                                    wl_rand(&wl->rng) % wl->dev_cdf[wl->cfg.n_devices - 1]);
+
+    //# Page
+    switch (wl->cfg.pattern)
+    {
+        case WL_SEQUENTIAL:
+            acc->page = i % n_pages;
+            break;
+
+        case WL_STRIDED:
+            // Shift by one page on every wrap, so all pages are eventually touched
+            acc->page = ((i * wl->cfg.stride) + ((i * wl->cfg.stride) / n_pages)) % n_pages;
+            break;
+
+        case WL_ZIPF:
+            acc->page = zipf_perm[wl_cdf_search(zipf_cdf, n_pages,
+                                    wl_rand(&wl->rng) % zipf_cdf[n_pages - 1])];
+            break;
+
+        case WL_PHASED:
+            if (i != 0 && (i % wl->cfg.phase_len) == 0)
+                wl->phase_base = (wl->phase_base + wl->cfg.phase_pages) % n_pages;
+            acc->page = (wl->phase_base + (wl_rand(&wl->rng) % wl->cfg.phase_pages)) % n_pages;
+            break;
+
+        default:
+            acc->page = wl_rand(&wl->rng) % n_pages;
+            break;
+    }
+}
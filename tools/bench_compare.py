@@ -0,0 +1,186 @@
+#!/usr/bin/env python3
+"""
+Compare the benchmark results of a captured UART log against a baseline log.
+
+Both logs must be produced with OUTPUT_FMT=OUTPUT_CSV or OUTPUT_FMT=OUTPUT_JSON. Lines that are
+not structured records (log messages) are ignored.
+
+The direction of each metric is derived from its unit. Units listed in LOWER_IS_BETTER, or
+starting with one of LOWER_IS_BETTER_PREFIXES, are lower-is-better: latencies ('cycles',
+'cycles/...'), miss counts and rates ('misses', 'misses/req'), MMIO access counts of
+MMIO_STATS=1 builds ('accesses') and slowdowns w.r.t. a baseline configuration ('x_overhead'). Remaining units containing '/' (e.g. B/cycle, xfers/kcycle)
+are throughputs, and 'x' are speedups (higher is better). Other units (samples, records, ...)
+are informational and only reported with --verbose.
+
+Tolerances are relative (0.05 = 5%) and can be set per metric with glob patterns matched
+against "test/metric", either with --tol or with a JSON file mapping patterns to tolerances.
+The first matching pattern applies; --tol patterns are matched before the file ones.
+
+Exit status is 1 if any regression, failed test or missing metric is found, 0 otherwise.
+
+Examples:
+    bench_compare.py baseline.log run.log
+    bench_compare.py baseline.log run.log --default-tol 0.1 --tol '*/*.p99.9=0.3'
+    bench_compare.py baseline.log run.log --tol-file tolerances.json
+"""
+
+import argparse
+import csv
+import fnmatch
+import json
+import sys
+
+RECORD_TYPES = ("test", "assert", "bench", "summary")
+
+# Units of lower-is-better metrics, checked before the throughput ('/') fallback
+LOWER_IS_BETTER = ("cycles", "accesses", "misses", "misses/req", "x_overhead")
+LOWER_IS_BETTER_PREFIXES = ("cycles/", "misses/")
+
+# Higher-is-better units without '/'
+HIGHER_IS_BETTER = ("x",)
+
+
+def parse_record(line):
+    """Returns the record of a log line as a dict, or None if the line is not a record"""
+    line = line.strip()
+
+    if line.startswith("{"):
+        try:
+            rec = json.loads(line)
+        except ValueError:
+            return None
+        return rec if rec.get("type") in RECORD_TYPES else None
+
+    if line.split(",", 1)[0] not in RECORD_TYPES:
+        return None
+
+    fields = next(csv.reader([line]))
+    if len(fields) != 5:
+        return None
+
+    try:
+        value = float(fields[3])
+    except ValueError:
+        return None
+
+    return {"type": fields[0], "test": fields[1], "name": fields[2], "value": value, "unit": fields[4]}
+
+
+def parse_log(path):
+    """Returns the benchmark metrics and test results of a log"""
+    metrics = {}
+    tests = {}
+    complete = False
+
+    with open(path, errors="replace") as f:
+        for line in f:
+            rec = parse_record(line)
+            if rec is None:
+                continue
+
+            key = "%s/%s" % (rec["test"], rec["name"])
+            if rec["type"] == "bench":
+                metrics[key] = (float(rec["value"]), rec["unit"])
+            elif rec["type"] == "test":
+                tests[rec["test"]] = bool(rec["value"])
+            elif rec["type"] == "summary":
+                complete = True
+
+    return metrics, tests, complete
+
+
+def direction(unit):
+    """Returns +1 if higher is better, -1 if lower is better, and 0 for informational units"""
+    if unit in LOWER_IS_BETTER or unit.startswith(LOWER_IS_BETTER_PREFIXES):
+        return -1
+    if "/" in unit or unit in HIGHER_IS_BETTER:
+        return 1
+    return 0
+
+
+def tolerance(key, tols, default):
+    for pattern, tol in tols:
+        if fnmatch.fnmatchcase(key, pattern):
+            return tol
+    return default
+
+
+def parse_tol(arg):
+    pattern, sep, tol = arg.rpartition("=")
+    if not sep:
+        raise argparse.ArgumentTypeError("expected PATTERN=TOL, got '%s'" % arg)
+    return pattern, float(tol)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("baseline", help="baseline log")
+    parser.add_argument("log", help="log to compare against the baseline")
+    parser.add_argument("--default-tol", type=float, default=0.05, help="default relative tolerance (default: 0.05)")
+    parser.add_argument("--tol", type=parse_tol, action="append", default=[], metavar="PATTERN=TOL",
+                        help="relative tolerance of the metrics matching PATTERN")
+    parser.add_argument("--tol-file", help="JSON file mapping metric patterns to relative tolerances")
+    parser.add_argument("-v", "--verbose", action="store_true", help="print all compared metrics")
+    args = parser.parse_args()
+
+    tols = list(args.tol)
+    if args.tol_file:
+        with open(args.tol_file) as f:
+            tols += list(json.load(f).items())
+
+    base_metrics, base_tests, _ = parse_log(args.baseline)
+    metrics, tests, complete = parse_log(args.log)
+
+    if not base_metrics and not base_tests:
+        sys.exit("%s: no structured records found" % args.baseline)
+
+    n_regressions = 0
+    n_improvements = 0
+    n_missing = 0
+    n_failed = 0
+
+    if not complete:
+        print("INCOMPLETE: %s has no summary record (run aborted?)" % args.log)
+
+    for test, passed in sorted(tests.items()):
+        if not passed:
+            n_failed += 1
+            was = "" if base_tests.get(test, True) else " (also in baseline)"
+            print("FAILED      %s%s" % (test, was))
+
+    for key, (base, unit) in sorted(base_metrics.items()):
+        if key not in metrics:
+            n_missing += 1
+            print("MISSING     %s" % key)
+            continue
+
+        value = metrics[key][0]
+        sign = direction(unit)
+        tol = tolerance(key, tols, args.default_tol)
+        delta = (value - base) / base if base != 0 else (0.0 if value == 0 else float("inf"))
+
+        if sign == 0 or abs(delta) <= tol:
+            status = "ok" if sign != 0 else "info"
+        elif delta * sign < 0:
+            status = "REGRESSION"
+            n_regressions += 1
+        else:
+            status = "improved"
+            n_improvements += 1
+
+        if args.verbose or status in ("REGRESSION", "improved"):
+            print("%-11s %-64s %14.3f -> %14.3f %-12s (%+.1f%%, tol %.1f%%)"
+                  % (status, key, base, value, unit, delta * 100, tol * 100))
+
+    for key in sorted(set(metrics) - set(base_metrics)):
+        if args.verbose:
+            print("%-11s %s" % ("new", key))
+
+    print("%d metrics compared: %d regressions, %d improvements, %d missing, %d failed tests"
+          % (len(base_metrics), n_regressions, n_improvements, n_missing, n_failed))
+
+    return 1 if (n_regressions or n_missing or n_failed or not complete) else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,184 @@
+/**
+ *  Build-time generator of the IOMMU tables (STATIC_TABLES=1).
+ *
+ *  Runs the same init functions used at boot (s1pt_init(), s2pt_init(), msi_pt_init(), mrif_init()
+ *  and ddt_init()) on host copies of the tables, and emits the result as pre-initialized data in an
+ *  assembly file. Words holding the address of another table (non-leaf PTEs, MRIF pointers, DC root
+ *  pointers) are emitted as link-time relocations against symbols defined in a linker script fragment:
+ *      __<table>_pte = <table> >> 2    (PTE and MSI PTE address fields)
+ *      __<table>_pfn = <table> >> 12   (DC.iohgatp, DC.fsc and DC.msiptp PPN fields)
+ *  so the output does not depend on the link addresses of the firmware.
+ *
+ *  Built and run by the Makefile with the same headers as the firmware, but with the host compiler
+ *  (see tools/host_shim.h). Must be built as a PIE, so host addresses never overlap the physical
+ *  addresses held by the tables.
+ *
+ *  Usage: gen_tables <out.S> <out.ld>
+ */
+
+#include <rv_iommu_dc.h>
+#include <page_tables.h>
+
+#define TABLE(t, size, align)   {#t, (uint64_t*)(t), (size), (align)}
+
+static const struct table {
+    const char *name;
+    uint64_t *base;
+    size_t size;
+    size_t align;
+} tables[] = {
+    TABLE(s1pt,             PAGE_SIZE * S1PT_N_TABLES,          PAGE_SIZE),
+    TABLE(s2pt_root,        PAGE_SIZE * 4,                      PAGE_SIZE * 4),
+    TABLE(s2pt,             PAGE_SIZE * S2PT_N_TABLES,          PAGE_SIZE),
+    TABLE(msi_pt,           sizeof(uint64_t) * MSI_N_ENTRIES * 2, PAGE_SIZE),
+    TABLE(mrif,             sizeof(uint64_t) * MRIF_N_DWORDS,   512),
+    TABLE(s1pt_bench,       PAGE_SIZE * (1 + BENCH_N_PT),       PAGE_SIZE),
+    TABLE(s2pt_bench,       PAGE_SIZE * (1 + BENCH_N_PT),       PAGE_SIZE),
+    TABLE(s1pt_bench_2mib,  PAGE_SIZE,                          PAGE_SIZE),
+    TABLE(s2pt_bench_2mib,  PAGE_SIZE,                          PAGE_SIZE),
+    TABLE(root_ddt,         sizeof(ddt_t) * DDT_N_ENTRIES,      PAGE_SIZE),
+};
+#define N_TABLES    (sizeof(tables)/sizeof(tables[0]))
+
+// Host addresses of the tables are above any physical address of the target
+#define HOST_ADDR_MIN   (1ULL << 40)
+
+// Address fields of a word (bits [53:7] and [43:0]) decoded as a PTE/MSI PTE pointer and as a PPN
+#define PTE_FIELD(w)    (((w) & 0x003FFFFFFFFFFF80ULL) << 2)
+#define PFN_FIELD(w)    (((w) & 0x00000FFFFFFFFFFFULL) << 12)
+
+enum reloc { RELOC_NONE, RELOC_PTE, RELOC_PFN };
+
+// Symbols used by the generated tables (bit 0: __<table>_pte, bit 1: __<table>_pfn)
+static unsigned used[N_TABLES];
+
+// Returns the table holding the host address 'addr', or -1
+static int table_of(uint64_t addr)
+{
+    for (int t = 0; t < N_TABLES; t++)
+    {
+        uint64_t base = (uintptr_t)tables[t].base;
+        if (addr >= base && addr < base + tables[t].size)
+            return t;
+    }
+
+    return -1;
+}
+
+/**
+ *  Write a word of a table. Words pointing to a table are written as a relocation
+ *  plus the remaining bits (page offset and flags) as addend
+ */
+static void emit_word(FILE *f, uint64_t w)
+{
+    int t_pte = table_of(PTE_FIELD(w));
+    int t_pfn = table_of(PFN_FIELD(w));
+
+    if (t_pte >= 0 && t_pfn >= 0)
+    {
+        fprintf(stderr, "gen_tables: ambiguous word 0x%016llx\n", (unsigned long long)w);
+        exit(1);
+    }
+
+    if (t_pte >= 0)
+    {
+        used[t_pte] |= (1 << RELOC_PTE);
+        fprintf(f, "\t.dword __%s_pte + 0x%llx\n", tables[t_pte].name,
+                (unsigned long long)(w - ((uintptr_t)tables[t_pte].base >> 2)));
+    }
+    else if (t_pfn >= 0)
+    {
+        used[t_pfn] |= (1 << RELOC_PFN);
+        fprintf(f, "\t.dword __%s_pfn + 0x%llx\n", tables[t_pfn].name,
+                (unsigned long long)(w - ((uintptr_t)tables[t_pfn].base >> 12)));
+    }
+    else
+    {
+        fprintf(f, "\t.dword 0x%llx\n", (unsigned long long)w);
+    }
+}
+
+static void emit_table(FILE *f, const struct table *t)
+{
+    size_t n_words = t->size / sizeof(uint64_t);
+
+    fprintf(f, "\n\t.globl %s\n\t.balign %zu\n%s:\n", t->name, t->align, t->name);
+
+    for (size_t i = 0; i < n_words; i++)
+    {
+        // Runs of zeros
+        size_t n_zeros = 0;
+        while (i + n_zeros < n_words && t->base[i + n_zeros] == 0)
+            n_zeros++;
+
+        if (n_zeros > 0)
+        {
+            fprintf(f, "\t.zero %zu\n", n_zeros * sizeof(uint64_t));
+            i += n_zeros - 1;
+            continue;
+        }
+
+        emit_word(f, t->base[i]);
+    }
+
+    fprintf(f, "\t.size %s, %zu\n", t->name, t->size);
+}
+
+int main(int argc, char **argv)
+{
+    if (argc != 3)
+    {
+        fprintf(stderr, "usage: %s <out.S> <out.ld>\n", argv[0]);
+        return 1;
+    }
+
+    for (int t = 0; t < N_TABLES; t++)
+    {
+        if ((uintptr_t)tables[t].base < HOST_ADDR_MIN)
+        {
+            fprintf(stderr, "gen_tables: %s at host address %p, build the generator as a PIE\n",
+                    tables[t].name, (void*)tables[t].base);
+            return 1;
+        }
+    }
+
+    //# Same sequence as init_iommu()
+    s2pt_init();
+    s1pt_init();
+    msi_pt_init();
+    mrif_init();
+    ddt_init();
+
+    //# Tables
+    FILE *f = fopen(argv[1], "w");
+    if (f == NULL)
+    {
+        perror(argv[1]);
+        return 1;
+    }
+
+    fprintf(f, "/* Generated by tools/gen_tables.c. Do not edit */\n\n\t.section .data\n");
+    for (int t = 0; t < N_TABLES; t++)
+        emit_table(f, &tables[t]);
+    fclose(f);
+
+    //# Relocation symbols
+    f = fopen(argv[2], "w");
+    if (f == NULL)
+    {
+        perror(argv[2]);
+        return 1;
+    }
+
+    fprintf(f, "/* Generated by tools/gen_tables.c. Do not edit */\n");
+    for (int t = 0; t < N_TABLES; t++)
+    {
+        if (used[t] & (1 << RELOC_PTE))
+            fprintf(f, "__%s_pte = %s >> 2;\n", tables[t].name, tables[t].name);
+        if (used[t] & (1 << RELOC_PFN))
+            fprintf(f, "__%s_pfn = %s >> 12;\n", tables[t].name, tables[t].name);
+    }
+    fclose(f);
+
+    return 0;
+}
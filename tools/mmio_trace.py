@@ -0,0 +1,248 @@
+#!/usr/bin/env python3
+"""
+Summarize or replay the MMIO traces of a captured UART log (firmware built with MMIO_TRACE=1).
+
+Each trace block starts with "MMIO_TRACE <name> <n_entries> <n_dropped> <base>" and ends with
+"MMIO_TRACE_END". Blocks are named after the test they belong to ("boot", "restore", "end" and
+"error" are printed outside tests). Each access line holds the cycles elapsed since the previous
+access, the direction (r/w) and size in bytes, the offset w.r.t. <base> and the value (hex).
+
+Commands:
+    summary     Per block: accesses, reads/writes, cycle span and the most accessed registers.
+                Writes of the value a register already holds and reads returning the same value
+                as the previous read with no write in between are counted as redundant.
+    timeline    Print every access with its absolute cycle and register name.
+    replay      Replay the accesses against a software model of the register file. Reads of
+                software-owned registers (written only by software) must return the last written
+                value; mismatches (e.g., WARL fields, lost writes) are reported.
+
+Examples:
+    mmio_trace.py run.log
+    mmio_trace.py run.log timeline --block iotinval
+    mmio_trace.py run.log replay
+    mmio_trace.py run.log summary --n-iommu 2
+"""
+
+import argparse
+import collections
+import sys
+
+IOMMU_REGS = {
+    0x000: ("capabilities", False),
+    0x008: ("fctl", True),
+    0x010: ("ddtp", False),
+    0x018: ("cqb", True),
+    0x020: ("cqh", False),
+    0x024: ("cqt", True),
+    0x028: ("fqb", True),
+    0x030: ("fqh", True),
+    0x034: ("fqt", False),
+    0x038: ("pqb", True),
+    0x040: ("pqh", True),
+    0x044: ("pqt", False),
+    0x048: ("cqcsr", False),
+    0x04C: ("fqcsr", False),
+    0x050: ("pqcsr", False),
+    0x054: ("ipsr", False),
+    0x058: ("iocntovf", False),
+    0x05C: ("iocntinh", True),
+    0x060: ("iohpmcycles", False),
+    0x258: ("tr_req_iova", True),
+    0x260: ("tr_req_ctl", False),
+    0x268: ("tr_response", False),
+    0x2F8: ("icvec", True),
+}
+for i in range(31):
+    IOMMU_REGS[0x068 + 8 * i] = ("iohpmctr%d" % (i + 1), False)
+    IOMMU_REGS[0x160 + 8 * i] = ("iohpmevt%d" % (i + 1), True)
+for i in range(16):
+    IOMMU_REGS[0x300 + 16 * i] = ("msi_addr%d" % i, True)
+    IOMMU_REGS[0x308 + 16 * i] = ("msi_data%d" % i, True)
+    IOMMU_REGS[0x30C + 16 * i] = ("msi_vctl%d" % i, True)
+
+IDMA_REGS = {
+    0x00: ("src_addr", True),
+    0x08: ("dest_addr", True),
+    0x10: ("num_bytes", True),
+    0x18: ("config", True),
+    0x20: ("status", False),
+    0x28: ("next_transfer_id", False),
+    0x30: ("last_transfer_id_complete", False),
+    0x38: ("ipsr", False),
+}
+
+
+class Access(object):
+    __slots__ = ("cycle", "write", "size", "addr", "value")
+
+    def __init__(self, cycle, write, size, addr, value):
+        self.cycle = cycle
+        self.write = write
+        self.size = size
+        self.addr = addr
+        self.value = value
+
+
+class Block(object):
+    def __init__(self, name, dropped):
+        self.name = name
+        self.dropped = dropped
+        self.accesses = []
+
+
+def parse_log(path):
+    """Returns the trace blocks of a log"""
+    blocks = []
+    block = None
+    base = 0
+    cycle = 0
+
+    with open(path, errors="replace") as f:
+        for line in f:
+            fields = line.split()
+            if not fields:
+                continue
+
+            if fields[0] == "MMIO_TRACE" and len(fields) == 5:
+                block = Block(fields[1], int(fields[3]))
+                base = int(fields[4], 16)
+                cycle = 0
+                continue
+
+            if block is None:
+                continue
+
+            if fields[0] == "MMIO_TRACE_END":
+                blocks.append(block)
+                block = None
+                continue
+
+            if len(fields) != 4 or fields[1][0] not in "rw":
+                continue
+
+            cycle += int(fields[0], 16)
+            block.accesses.append(Access(cycle, fields[1][0] == "w", int(fields[1][1:]),
+                                         base + int(fields[2], 16), int(fields[3], 16)))
+
+    if block is not None:
+        print("warning: trace '%s' is truncated" % block.name, file=sys.stderr)
+        blocks.append(block)
+
+    return blocks
+
+
+# Stride between the register interfaces of IOMMU instances (PLAT_IOMMU_BASE() in platform.h)
+IOMMU_STRIDE = 0x1000
+
+
+class RegisterMap(object):
+    def __init__(self, iommu_base, idma_bases, n_iommu=1):
+        self.iommu_bases = [iommu_base + i * IOMMU_STRIDE for i in range(n_iommu)]
+        self.idma_bases = idma_bases
+
+    def lookup(self, addr):
+        """Returns (name, software-owned) of the register at addr. Registers of instance i > 0
+        are prefixed with "iommu<i>." """
+        for i, base in enumerate(self.iommu_bases):
+            off = addr - base
+            if off in IOMMU_REGS:
+                name, sw = IOMMU_REGS[off]
+                return (name if i == 0 else "iommu%d.%s" % (i, name), sw)
+
+        for i, base in enumerate(self.idma_bases):
+            off = addr - base
+            if off in IDMA_REGS:
+                name, sw = IDMA_REGS[off]
+                return ("idma%d.%s" % (i, name), sw)
+
+        return ("0x%x" % addr, False)
+
+
+def summary(blocks, regs, top):
+    for b in blocks:
+        acc = b.accesses
+        if not acc:
+            continue
+
+        n_writes = sum(1 for a in acc if a.write)
+        span = acc[-1].cycle - acc[0].cycle
+        counts = collections.Counter()
+        redundant = collections.Counter()
+        last = {}
+
+        for a in acc:
+            name = regs.lookup(a.addr)[0]
+            counts[name] += 1
+            prev = last.get(a.addr)
+            if prev is not None and prev[1] == a.value and (a.write or not prev[0]):
+                redundant[name] += 1
+            last[a.addr] = (a.write, a.value)
+
+        print("%s: %d accesses (%d reads, %d writes) in %d cycles%s"
+              % (b.name, len(acc), len(acc) - n_writes, n_writes, span,
+                 " (%d older accesses dropped)" % b.dropped if b.dropped else ""))
+
+        for name, n in counts.most_common(top):
+            print("    %-32s %8d %8d redundant" % (name, n, redundant[name]))
+
+
+def timeline(blocks, regs):
+    for b in blocks:
+        print("== %s" % b.name)
+        for a in b.accesses:
+            print("%14d %s%d %-32s 0x%x" % (a.cycle, "W" if a.write else "R", a.size, regs.lookup(a.addr)[0], a.value))
+
+
+def replay(blocks, regs):
+    """Returns the number of mismatches w.r.t. the software model"""
+    n_mismatches = 0
+
+    for b in blocks:
+        model = {}
+        for a in b.accesses:
+            name, sw = regs.lookup(a.addr)
+            if not a.write and sw and a.addr in model and model[a.addr] != a.value:
+                n_mismatches += 1
+                print("%s: cycle %d: %s read 0x%x, last written 0x%x"
+                      % (b.name, a.cycle, name, a.value, model[a.addr]))
+            model[a.addr] = a.value
+
+    print("%d blocks replayed: %d mismatches" % (len(blocks), n_mismatches))
+
+    return n_mismatches
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("log", help="captured UART log")
+    parser.add_argument("command", nargs="?", default="summary", choices=("summary", "timeline", "replay"))
+    parser.add_argument("--block", action="append", default=[], help="only process the blocks with this name")
+    parser.add_argument("--top", type=int, default=8, help="registers listed per block (default: 8)")
+    parser.add_argument("--iommu-base", type=lambda x: int(x, 0), default=0x50010000, help="IOMMU base address")
+    parser.add_argument("--n-iommu", type=int, default=1,
+                        help="IOMMU instances, 0x%x apart (N_IOMMU of the build, default: 1)" % IOMMU_STRIDE)
+    parser.add_argument("--idma-base", type=lambda x: int(x, 0), action="append", default=[],
+                        help="iDMA base address (default: 0x50000000)")
+    args = parser.parse_args()
+
+    blocks = parse_log(args.log)
+    if args.block:
+        blocks = [b for b in blocks if b.name in args.block]
+
+    if not blocks:
+        sys.exit("%s: no MMIO traces found" % args.log)
+
+    regs = RegisterMap(args.iommu_base, args.idma_base or [0x50000000], args.n_iommu)
+
+    if args.command == "timeline":
+        timeline(blocks, regs)
+    elif args.command == "replay":
+        return 1 if replay(blocks, regs) else 0
+    else:
+        summary(blocks, regs, args.top)
+
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
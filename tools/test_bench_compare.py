@@ -0,0 +1,80 @@
+#!/usr/bin/env python3
+"""
+Tests of bench_compare.py. Run with: python3 tools/test_bench_compare.py
+"""
+
+import os
+import subprocess
+import sys
+import tempfile
+import unittest
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+import bench_compare
+
+SCRIPT = os.path.join(os.path.dirname(os.path.abspath(__file__)), "bench_compare.py")
+
+
+def write_log(lines):
+    f = tempfile.NamedTemporaryFile("w", suffix=".log", delete=False)
+    f.write("\n".join(lines + ["summary,,passed,1,asserts", "summary,,total,1,asserts"]) + "\n")
+    f.close()
+    return f.name
+
+
+class DirectionTest(unittest.TestCase):
+    def test_lower_is_better(self):
+        for unit in ("cycles", "accesses", "misses", "misses/req", "cycles/xfer", "x_overhead"):
+            self.assertEqual(bench_compare.direction(unit), -1, unit)
+
+    def test_higher_is_better(self):
+        for unit in ("B/cycle", "xfers/kcycle", "ops/kcycle", "xlat/s", "x"):
+            self.assertEqual(bench_compare.direction(unit), 1, unit)
+
+    def test_informational(self):
+        for unit in ("samples", "records", "events", "bytes"):
+            self.assertEqual(bench_compare.direction(unit), 0, unit)
+
+
+class CompareTest(unittest.TestCase):
+    def compare(self, base, new):
+        logs = [write_log([base]), write_log([new])]
+        try:
+            return subprocess.run([sys.executable, SCRIPT] + logs, capture_output=True, text=True)
+        finally:
+            for log in logs:
+                os.unlink(log)
+
+    def test_miss_rate_increase_is_regression(self):
+        res = self.compare("bench,translation_workloads,uniform.iotlb_miss_rate,0.100,misses/req",
+                           "bench,translation_workloads,uniform.iotlb_miss_rate,0.900,misses/req")
+        self.assertEqual(res.returncode, 1)
+        self.assertIn("REGRESSION", res.stdout)
+
+    def test_miss_rate_decrease_is_improvement(self):
+        res = self.compare("bench,translation_workloads,uniform.iotlb_miss_rate,0.900,misses/req",
+                           "bench,translation_workloads,uniform.iotlb_miss_rate,0.100,misses/req")
+        self.assertEqual(res.returncode, 0)
+        self.assertIn("improved", res.stdout)
+
+    def test_overhead_increase_is_regression(self):
+        res = self.compare("bench,dma_bandwidth_sweep,two_stage.4k.4096.overhead,1.100,x_overhead",
+                           "bench,dma_bandwidth_sweep,two_stage.4k.4096.overhead,2.500,x_overhead")
+        self.assertEqual(res.returncode, 1)
+        self.assertIn("REGRESSION", res.stdout)
+
+    def test_scaling_decrease_is_regression(self):
+        res = self.compare("bench,multi_iommu_scaling,n2.scaling,1.900,x",
+                           "bench,multi_iommu_scaling,n2.scaling,1.200,x")
+        self.assertEqual(res.returncode, 1)
+        self.assertIn("REGRESSION", res.stdout)
+
+    def test_throughput_decrease_is_regression(self):
+        res = self.compare("bench,dma_bandwidth_sweep,4k.bandwidth,2.000,B/cycle",
+                           "bench,dma_bandwidth_sweep,4k.bandwidth,1.000,B/cycle")
+        self.assertEqual(res.returncode, 1)
+        self.assertIn("REGRESSION", res.stdout)
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -0,0 +1,112 @@
+#!/usr/bin/env python3
+"""
+Tests of mmio_trace.py. Run with: python3 tools/test_mmio_trace.py
+"""
+
+import contextlib
+import io
+import os
+import subprocess
+import sys
+import tempfile
+import unittest
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+import mmio_trace
+
+SCRIPT = os.path.join(os.path.dirname(os.path.abspath(__file__)), "mmio_trace.py")
+
+# Two blocks traced from the IOMMU base, with UART output interleaved
+DUMP = [
+    "Running test iotinval",
+    "MMIO_TRACE boot 4 0 0x50010000",
+    "10 w8 8 2",
+    "5 r8 8 2",
+    "3 w4 24 1",
+    "2 w4 24 1",
+    "MMIO_TRACE_END",
+    "[PASS] iotinval",
+    "MMIO_TRACE iotinval 3 7 0x50010000",
+    "20 w4 5c 7",
+    "4 r4 5c 0",
+    "1 r4 20 0",
+    "MMIO_TRACE_END",
+]
+
+
+def write_log(lines):
+    f = tempfile.NamedTemporaryFile("w", suffix=".log", delete=False)
+    f.write("\n".join(lines) + "\n")
+    f.close()
+    return f.name
+
+
+class TraceTest(unittest.TestCase):
+    def setUp(self):
+        self.log = write_log(DUMP)
+        self.regs = mmio_trace.RegisterMap(0x50010000, [0x50000000])
+
+    def tearDown(self):
+        os.unlink(self.log)
+
+    def run_quiet(self, func, *args):
+        out = io.StringIO()
+        with contextlib.redirect_stdout(out):
+            ret = func(*args)
+        return ret, out.getvalue()
+
+    def test_parse(self):
+        blocks = mmio_trace.parse_log(self.log)
+        self.assertEqual([b.name for b in blocks], ["boot", "iotinval"])
+        self.assertEqual([b.dropped for b in blocks], [0, 7])
+
+        acc = blocks[0].accesses
+        self.assertEqual([a.cycle for a in acc], [0x10, 0x15, 0x18, 0x1a])
+        self.assertEqual([a.write for a in acc], [True, False, True, True])
+        self.assertEqual([a.size for a in acc], [8, 8, 4, 4])
+        self.assertEqual(acc[2].addr, 0x50010024)
+        self.assertEqual(self.regs.lookup(acc[2].addr), ("cqt", True))
+
+    def test_parse_truncated(self):
+        log = write_log(DUMP[:4])
+        try:
+            with contextlib.redirect_stderr(io.StringIO()):
+                blocks = mmio_trace.parse_log(log)
+        finally:
+            os.unlink(log)
+        self.assertEqual(len(blocks), 1)
+        self.assertEqual(len(blocks[0].accesses), 2)
+
+    def test_summary(self):
+        _, out = self.run_quiet(mmio_trace.summary, mmio_trace.parse_log(self.log), self.regs, 8)
+        self.assertIn("boot: 4 accesses (1 reads, 3 writes) in 10 cycles", out)
+        self.assertIn("iotinval: 3 accesses (2 reads, 1 writes) in 5 cycles (7 older accesses dropped)", out)
+        self.assertRegex(out, r"cqt\s+2\s+1 redundant")
+        self.assertRegex(out, r"fctl\s+2\s+0 redundant")
+
+    def test_replay(self):
+        n, out = self.run_quiet(mmio_trace.replay, mmio_trace.parse_log(self.log), self.regs)
+        # iocntinh read back 0 after writing 7; cqh is not software-owned
+        self.assertEqual(n, 1)
+        self.assertIn("iotinval: cycle 36: iocntinh read 0x0, last written 0x7", out)
+
+    def test_instances(self):
+        regs = mmio_trace.RegisterMap(0x50010000, [0x50000000], 3)
+        self.assertEqual(regs.lookup(0x50010024), ("cqt", True))
+        self.assertEqual(regs.lookup(0x50011024), ("iommu1.cqt", True))
+        self.assertEqual(regs.lookup(0x50012020), ("iommu2.cqh", False))
+        self.assertEqual(regs.lookup(0x50013024)[0], "0x50013024")
+        self.assertEqual(regs.lookup(0x50000030), ("idma0.last_transfer_id_complete", False))
+
+    def test_command_line(self):
+        res = subprocess.run([sys.executable, SCRIPT, self.log, "replay", "--block", "boot"],
+                             capture_output=True, text=True)
+        self.assertEqual(res.returncode, 0)
+        self.assertIn("1 blocks replayed: 0 mismatches", res.stdout)
+
+        res = subprocess.run([sys.executable, SCRIPT, self.log, "replay"], capture_output=True, text=True)
+        self.assertEqual(res.returncode, 1)
+
+
+if __name__ == "__main__":
+    unittest.main()